@@ -1,19 +1,26 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include <string>
 #include <vector>
-#include <list>
 #include <memory>
 #include <iostream>
 #include <fstream>
-#include <thread>
 #include <mutex>
-#include <condition_variable>
+#include <atomic>
 #include <algorithm>
+#include <numeric>
+#include <filesystem>
 #include <type_traits> // Used to determine if template type is floating point or not.
 #include "fftHelper.h"
+#include "fftKernels.h"
 #include "hsvrgb.h"
+#include "WorkerPool.h"
+#include "MappedFile.h"
+#include "LargeBuffer.h"
+#include "Profiler.h"
+#include "PngEncoder.h"
 #include "BitmapPlusPlus.hpp"
 #include "fpng.h"
 
@@ -29,30 +36,120 @@ typedef struct tFileToHeatMapConfig
    bool normalizeHeatMap = false;
    double maxLevelDb = std::numeric_limits<double>::infinity(); // init to invalid value
    double rangeDb = 100.0;
+   size_t fftBatchSize = 0; // Number of FFTs to run per FFTW call. 0 means pick based on the FFT size.
+   bool memoryMapInput = false; // Workers read the samples directly out of a memory mapped input file.
+   bool fastPngEncode = false; // Faster PNG compression at the cost of bigger files.
+   size_t fftsPerRow = 1; // Number of consecutive FFTs combined into each row of the heat map.
+   size_t outputWidth = 0; // Number of frequency bins in the heat map. 0 (or >= fftSize) means 1 per FFT bin.
+   eBinReduce binReduce = E_REDUCE_MAX; // How adjacent FFT bins are reduced down to the output width.
+   ePowerCombine rowCombine = E_COMBINE_MEAN; // How the FFTs in a row are combined.
+   bool storeDb = false; // Keep the dB values (instead of mapping them straight to color levels), needed for saveDbCache.
+   bool renderFromDbCache = false; // filePath is a dB cache file (see loadDbCache), it is only rendered. The FFT settings come from the cache.
+   std::shared_ptr<Profiler> profiler; // Per stage timing / trace events (see Profiler.h). Null means off.
+   bool autoScale = false; // Pick the color scale from percentiles of all the dB values (overrides maxLevelDb, rangeDb and normalizeHeatMap).
+   double autoScaleFloor = 50.0; // Percentile that maps to the lowest color, i.e. the noise floor.
+   double autoScaleTop = 99.9; // Percentile that maps to the highest color.
+   WorkerPool::eAffinity workerAffinity = WorkerPool::E_AFFINITY_NONE; // Only used when the heat map creates its own pool.
+   bool numaFirstTouch = false; // Workers allocate their own buffers and write whole pages of the heat map (see genHeatMap).
+   eHugePages hugePages = E_HUGE_PAGES_OFF; // Pages backing the heat map dB values / color levels / RGB.
 } tFileToHeatMapConfig;   
 
-template<typename tSampType>
+static constexpr const char* DB_CACHE_MAGIC = "FFTHMDB";
+static constexpr uint32_t DB_CACHE_VERSION = 2;
+static constexpr size_t DB_CACHE_DATA_OFFSET = 4096; // Page aligned.
+
+// Header of a dB cache file (see saveDbCache). The dB values (tFftType, row by row) start at
+// 'dataOffset', which is aligned so the values can be used straight out of a memory mapping.
+typedef struct tDbCacheHeader
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t fftTypeSize; // sizeof(tFftType)
+   uint32_t sampTypeSize; // sizeof(tSampType)
+   uint32_t sampTypeIsFloat;
+   uint32_t sampTypeIsSigned;
+   uint64_t fftSize;
+   uint64_t numBins; // Values per row.
+   uint64_t numRows;
+   uint64_t sampBetweenFfts;
+   uint64_t fftsPerRow;
+   double sampleRate;
+   double fftMax_dB;
+   double fftMin_dB;
+   uint64_t dataOffset;
+} tDbCacheHeader;
+
+// Reads the header of a dB cache file, e.g. to find the types a cache was made with before creating
+// the FileToHeatMap to render it. Returns false if the file isn't a dB cache file.
+inline bool readDbCacheHeader(const std::string& cachePath, tDbCacheHeader& header)
+{
+   std::ifstream cacheFile(cachePath, std::ios::binary);
+   if(!cacheFile.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+   return memcmp(header.magic, DB_CACHE_MAGIC, sizeof(header.magic)) == 0 && header.version == DB_CACHE_VERSION;
+}
+
+// tFftType is the floating point type used for all the FFT processing (double or float). float halves
+// the memory needed to store the heat map and doubles the SIMD width, at the cost of precision that
+// doesn't matter once the values have been mapped to 256 color levels.
+template<typename tSampType, typename tFftType = double>
 class FileToHeatMap
 {
 public:
    // Public Constants
    static constexpr size_t COMPLEX_SAMP_SIZE = 2*sizeof(tSampType);
+   static constexpr double DB_HIST_MIN = -400.0; // dB values outside of the histogram range are counted in the first / last bin.
+   static constexpr double DB_HIST_MAX = 400.0;
+   static constexpr size_t DB_HIST_BINS_PER_DB = 10;
+   static constexpr size_t DB_HIST_NUM_BINS = size_t(DB_HIST_MAX - DB_HIST_MIN) * DB_HIST_BINS_PER_DB;
 
 public:
-   FileToHeatMap(const tFileToHeatMapConfig& config);
+   // 'workerPool' can be shared between multiple heat maps (config.numThreads is ignored when it is
+   // set). The heat maps can't use the same pool at the same time though. Otherwise a pool with
+   // config.numThreads threads is created.
+   FileToHeatMap(const tFileToHeatMapConfig& config, std::shared_ptr<WorkerPool> workerPool = nullptr);
    virtual ~FileToHeatMap();
 
    void genHeatMap();
 
+   // Generates the heat map and saves it as it goes, i.e. a PNG file is written as soon as all of its
+   // FFTs are done. The full heat map is never stored in memory, so this only works when the dB to
+   // RGB scaling is known before any FFTs are run (i.e. not normalized) and the dB values aren't
+   // needed afterwards (i.e. not config.storeDb).
+   //
+   // For files that are still growing, 'firstFile' skips the files that were already completed by a
+   // previous call. Returns the number of complete files, i.e. files that won't change if more
+   // samples are appended to the input (the last file may be partial, it is rewritten next time).
+   size_t genHeatMapPngSplit(const std::string& savePathNoExt, size_t maxNumFftsPerFile, bool rotate = false, size_t firstFile = 0);
+
    void saveBmp(const std::string& savePath, bool rotate = false);
    void savePng(const std::string& savePath, bool rotate = false);
 
    void savePngSplit(const std::string& savePathNoExt, size_t maxNumFftsPerFile, bool rotate = false);
 
+   // Saves the heat map as a pyramid of 'tileSize' x 'tileSize' PNG tiles, i.e. saveDir/z/x/y.png.
+   // Level 0 is full resolution and each level above it halves both axes (the max dB value of each
+   // 2x2 block), until the whole heat map fits in a single tile. Tiles on the right / bottom edges
+   // are padded with black so every tile is the same size.
+   void savePngPyramid(const std::string& saveDir, size_t tileSize, bool rotate = false);
+
+   // Saves the dB values (and everything needed to render them) to a cache file. Rendering with
+   // different scaling settings can then load the cache instead of running the FFTs again. The dB
+   // values must have been stored, i.e. config.storeDb or normalizeHeatMap.
+   bool saveDbCache(const std::string& cachePath);
+
+   // Loads a cache file made by saveDbCache in place of genHeatMap. The file is memory mapped, the
+   // dB values are read straight from the mapping while rendering.
+   bool loadDbCache(const std::string& cachePath);
+
    size_t getFftSize(){return m_fftSize;}
+   size_t getNumBins(){return m_numBins;}
    size_t getNumFfts(){return m_numFfts;}
    uint8_t* getRgb(){return m_rgb.data();}
 
+   // Renders 'numFFTs' FFTs starting at 'fftOffset' (0 means all of them) into the RGB buffer (see getRgb).
+   void fftToRgb(bool rotate, size_t fftOffset = 0, size_t numFFTs = 0);
+
 private:
    // Make uncopyable
    FileToHeatMap();
@@ -65,16 +162,30 @@ private:
    /////////////////////////////////////////////////////////////////////////////
    typedef struct tFftParam
    {
-      std::vector<tSampType> iqSamples;
-      std::vector<double> iSamples;
-      std::vector<double> qSamples;
-      std::vector<double> fftRe;
-      std::vector<double> fftIm;
-      double* fftWritePtr;
-
-      std::thread fftThread;
-
-      tFftParam(size_t fftSize): iqSamples(2*fftSize), iSamples(fftSize), qSamples(fftSize), fftRe(fftSize), fftIm(fftSize){}
+      std::vector<tSampType> iqSamples; // Samples for all the FFTs in the batch, back to back (not used when memory mapped).
+      std::vector<const tSampType*> iqFramePtrs; // Where to find the samples for each FFT in the batch.
+      size_t numFfts = 0; // Number of FFTs in the current batch.
+      size_t firstFft = 0; // Index of the first FFT in the current batch.
+      size_t firstRow = 0; // Row that dBRowsPtr / levelRowsPtr point to.
+      tFftType* dBRowsPtr = nullptr; // Where to write the dB values of the rows being processed (when storing dB values).
+      uint8_t* levelRowsPtr = nullptr; // Where to write the color levels of the rows being processed (when storing color levels).
+      tFftType* fftWritePtr = nullptr; // Where finishRow writes the dB values of the current row.
+      uint8_t* levelWritePtr = nullptr; // Where finishRow writes the color levels of the current row.
+      std::vector<tFftType> fft_dB; // dB values of a single FFT (when storing color levels).
+      std::vector<tFftType> rowPower; // Combined linear power of the FFTs in the current row (when combining FFTs / bins).
+      std::vector<tFftType> reducedPower; // rowPower reduced down to the output width.
+      size_t rowNumFfts = 0; // Number of FFTs combined into rowPower so far.
+
+      // RGB buffer for the PNG file / tile this worker is encoding.
+      std::vector<uint8_t> fileRgb;
+
+      // Stats for all the FFTs this worker has processed (merged after all the FFTs are done).
+      bool fftMaxMinNeedInit = true;
+      double fftMax_dB = 0;
+      double fftMin_dB = 0;
+      std::vector<uint64_t> dbHistogram; // Number of dB values in each histogram bin (only when auto scaling).
+
+      tFftParam(size_t fftSize, size_t batchSize, bool memoryMapped): iqSamples(memoryMapped ? 0 : 2*fftSize*batchSize), iqFramePtrs(batchSize), fft_dB(fftSize), rowPower(fftSize), reducedPower(fftSize){}
    }tFftParam;
    typedef std::shared_ptr<tFftParam> tFftParamPtr;
 
@@ -88,43 +199,94 @@ private:
    size_t m_fftSize = 1;
    double m_timeBetweenFfts = 1.0;
    size_t m_numThreads = 1;
+   size_t m_fftBatchSize = 1;
 
    size_t m_sampBetweenFfts = 1;
-   size_t m_numFfts = 0;
+   size_t m_numFfts = 0; // Number of rows in the heat map.
+   size_t m_numRawFfts = 0; // Number of FFTs to run (m_fftsPerRow FFTs per row).
+   size_t m_fftsPerRow = 1;
+   ePowerCombine m_rowCombine = E_COMBINE_MEAN;
+   size_t m_numBins = 1; // Width of a row of the heat map (can be less than the FFT size).
+   eBinReduce m_binReduce = E_REDUCE_MAX;
+   bool m_combinePower = false; // FFT results are combined in linear power before being converted to dB (i.e. multiple FFTs per row or reducing bins).
    size_t m_numSamples = 0;
 
    std::ifstream m_fileStream;
+   std::unique_ptr<MappedFile> m_mappedFile; // Only valid when reading directly from a memory mapped file.
    size_t m_fileSizeBytes = 0;
    size_t m_fileStartOffset = 0;
 
-   // FFT Window
-   std::vector<double> m_fftWindow;
-
-   // FFT Results
-   std::vector<double> m_fft_dB;
-   std::vector<uint8_t> m_rgb;
+   // FFT Window (interleaved, i.e. each coefficient is repeated for I and Q)
+   std::vector<tFftType> m_fftWindow;
+   bool m_fftShiftByModulation = false; // True if the window centers DC, i.e. the FFT output doesn't need to be swapped.
+
+   // FFT Results. When the dB to RGB scaling is known up front (i.e. not normalized) the workers map
+   // each dB value straight to its 8 bit color level and the dB values are never stored.
+   bool m_storeLevels = false;
+   LargeBuffer<tFftType> m_fft_dB;
+   const tFftType* m_dB = nullptr; // The stored dB values, either m_fft_dB or a memory mapped cache file.
+   size_t m_numDbStored = 0;
+   std::unique_ptr<MappedFile> m_cacheFile;
+   LargeBuffer<uint8_t> m_fftLevel;
+   LargeBuffer<uint8_t> m_rgb;
+   bool m_numaFirstTouch = false;
 
    bool m_normalizeHeatMap = false;
+   bool m_autoScale = false;
+   double m_autoScaleFloor = 50.0;
+   double m_autoScaleTop = 99.9;
+   bool m_fastPngEncode = false;
    double m_fftToRgb_max_dB = 0; // Any dB value above this will be the max RGB value.
    double m_fftToRgb_range_dB;
 
    // Threading
-   std::list<tFftParamPtr> m_fftThreadsAvailable;
+   std::shared_ptr<WorkerPool> m_workerPool;
+   std::vector<tFftParamPtr> m_fftThreadParams; // One per worker thread.
    std::mutex m_threadMutex;
-   std::condition_variable m_threadCondVar;
+
+   // Instrumentation (null when off)
+   std::shared_ptr<Profiler> m_profiler;
 
    // Stats
    bool m_fftMaxMinNeedInit = true;
    double m_fftMax_dB = 0;
    double m_fftMin_dB = 0;
+   std::vector<uint64_t> m_dbHistogram; // All the workers' histograms merged (only when auto scaling).
 
 
    /////////////////////////////////////////////////////////////////////////////
    // Private Member Functions
    /////////////////////////////////////////////////////////////////////////////
-   void readFromFile(std::shared_ptr<tFftParam> param, size_t fftNum);
+   void initScaling(const tFileToHeatMapConfig& config);
+   void createWorkers(const tFileToHeatMapConfig& config, std::shared_ptr<WorkerPool> workerPool);
+   void readFromFile(std::shared_ptr<tFftParam> param, size_t fftNum, size_t numFfts);
+   void processRows(std::shared_ptr<tFftParam> param, size_t beginRow, size_t endRow, tFftType* dBWritePtr, uint8_t* levelWritePtr);
    void doFft(std::shared_ptr<tFftParam> param);
-   void fftToRgb(bool rotate, size_t fftOffset = 0, size_t numFFTs = 0);
+   void finishRow(std::shared_ptr<tFftParam> param);
+   void updateStats(std::shared_ptr<tFftParam> param, tFftType fftMin, tFftType fftMax);
+   void updateHistogram(std::shared_ptr<tFftParam> param, const tFftType* fft_dB, size_t num);
+
+   // Render output rows [beginRow, endRow) of the image made from 'numFFTs' FFTs. 'rgbWritePtr'
+   // points to where 'beginRow' should be written.
+   void fftToRgb(const tFftType* fft_dB, size_t numFFTs, bool rotate, size_t beginRow, size_t endRow, uint8_t* rgbWritePtr, bool useWorkerPool);
+   void levelToRgb(const uint8_t* fftLevel, size_t numFFTs, bool rotate, size_t beginRow, size_t endRow, uint8_t* rgbWritePtr, bool useWorkerPool);
+   template<typename tFunc>
+   void renderRgb(size_t numFFTs, bool rotate, size_t beginRow, size_t endRow, uint8_t* rgbWritePtr, bool useWorkerPool, tFunc getLevel);
+
+   template<typename tFunc>
+   void savePngPyramid(const std::string& saveDir, size_t tileSize, bool rotate, tFunc getLevel);
+   template<typename tFunc>
+   void savePyramidLevel(const std::string& levelDir, size_t numFFTs, size_t numBins, size_t tileSize, bool rotate, tFunc getLevel);
+   template<typename tFunc>
+   void poolPyramidLevel(size_t numFFTs, size_t numBins, uint8_t* pooledLevel, tFunc getLevel);
+
+   void resetStats();
+   void mergeStats();
+   void mergeHistograms();
+   double getHistogramPercentile(double percentile);
+
+   uint32_t getFpngFlags(){return m_fastPngEncode ? 0 : fpng::FPNG_ENCODE_SLOWER;}
+   size_t getNumStored(){return m_storeLevels ? m_fftLevel.size() : m_numDbStored;}
 
 };
 
@@ -134,16 +296,26 @@ private:
 ////////////////////////////////////////////////////////////////////////////////
 
 
-template<typename tSampType>
-FileToHeatMap<tSampType>::FileToHeatMap(const tFileToHeatMapConfig& config)
+template<typename tSampType, typename tFftType>
+FileToHeatMap<tSampType, tFftType>::FileToHeatMap(const tFileToHeatMapConfig& config, std::shared_ptr<WorkerPool> workerPool)
    : m_filePath(config.filePath)
    , m_sampleRate(config.sampleRate)
    , m_fftSize(config.fftSize)
    , m_timeBetweenFfts(config.timeBetweenFfts)
    , m_numThreads(config.numThreads) 
+   , m_profiler(config.profiler)
 {
    try
    {
+      if(config.renderFromDbCache)
+      {
+         // Nothing to read as samples and no FFTs to run. loadDbCache fills in the rest.
+         m_fftSize = 0;
+         initScaling(config);
+         createWorkers(config, workerPool);
+         return;
+      }
+
       m_fileStream.open(m_filePath.c_str(), std::ios::binary);
 
       // Get the size of the file.
@@ -203,198 +375,698 @@ FileToHeatMap<tSampType>::FileToHeatMap(const tFileToHeatMapConfig& config)
          }
       }
 
-      m_fft_dB.resize(m_numFfts*m_fftSize);
-
-      // Determine Max FFT value
-      m_normalizeHeatMap = config.normalizeHeatMap;
-      if(std::isfinite(config.maxLevelDb))
-         m_fftToRgb_max_dB = config.maxLevelDb; // Use the user specified value.
-      else if(std::is_floating_point<tSampType>())
-         m_fftToRgb_max_dB = 0; // Floating point values could be anything. Set max to 0 dB
-      else
-         m_fftToRgb_max_dB = 20.0 * log10(double(std::numeric_limits<tSampType>::max())); // Set to max
-
-      m_fftToRgb_range_dB = config.rangeDb;
-      if(!std::isfinite(m_fftToRgb_range_dB) || m_fftToRgb_range_dB <= 0 || m_fftToRgb_range_dB > 1000) // Make sure the value makes sense.
+      // Each row of the heat map combines m_fftsPerRow FFTs (the last row may combine fewer).
+      m_fftsPerRow = std::max(size_t(1), config.fftsPerRow);
+      m_rowCombine = config.rowCombine;
+      m_numRawFfts = m_numFfts;
+      m_numFfts = (m_numRawFfts + m_fftsPerRow - 1) / m_fftsPerRow;
+
+      // Adjacent FFT bins can be reduced down to a narrower output width.
+      m_numBins = m_fftSize;
+      if(config.outputWidth > 0 && config.outputWidth < m_fftSize)
+         m_numBins = config.outputWidth;
+      m_binReduce = config.binReduce;
+      m_combinePower = m_fftsPerRow > 1 || m_numBins != m_fftSize;
+
+      initScaling(config);
+
+      // Generate Window Coefs (with the FFT normalization and, for even FFT sizes, the DC shift folded in)
+      dubVect fftWindow(m_fftSize);
+      m_fftShiftByModulation = genFftShiftWindowCoef(fftWindow.data(), m_fftSize);
+      m_fftWindow.resize(2*m_fftSize);
+      for(size_t i = 0; i < m_fftSize; ++i)
       {
-         m_fftToRgb_range_dB = 100;
+         m_fftWindow[2*i+0] = m_fftWindow[2*i+1] = tFftType(fftWindow[i]);
       }
 
-      // Generate Window Coefs
-      m_fftWindow.resize(m_fftSize);
-      genWindowCoef(m_fftWindow.data(), m_fftSize, true);
+      // Try to memory map the input. The samples must be aligned in memory, otherwise fall back to the file stream.
+      if(config.memoryMapInput && m_numFfts > 0 && (m_fileStartOffset % sizeof(tSampType)) == 0)
+      {
+         m_mappedFile.reset(new MappedFile(m_filePath));
+         if(m_mappedFile->isValid() && m_mappedFile->getSize() >= m_fileSizeBytes)
+         {
+            // Overlapping / back to back FFTs read the file sequentially. Otherwise there are gaps
+            // between the FFTs, so turn off read ahead and prefetch just the samples that are needed.
+            if(m_sampBetweenFfts <= m_fftSize)
+               m_mappedFile->setAccessPattern(MappedFile::E_ACCESS_SEQUENTIAL);
+            else
+               m_mappedFile->setAccessPattern(MappedFile::E_ACCESS_RANDOM);
+         }
+         else
+         {
+            m_mappedFile.reset();
+         }
+      }
 
-      // Create Worker Thread Params
-      if(m_numThreads <= 0){m_numThreads = 1;}
-      for(size_t i = 0; i < m_numThreads; ++i)
+      // Small FFTs are run in batches so the per FFTW call overhead is spread across many FFTs.
+      // The auto size keeps a batch's FFTW buffers around 512 kB so they stay in cache.
+      m_fftBatchSize = config.fftBatchSize;
+      if(m_fftBatchSize == 0)
+      {
+         m_fftBatchSize = std::max(size_t(1), std::min(size_t(64), size_t(16384) / m_fftSize));
+      }
+      if(m_fftsPerRow > 1 && m_fftsPerRow < m_fftBatchSize)
       {
-         m_fftThreadsAvailable.emplace_back(std::make_shared<tFftParam>(m_fftSize));
+         // Whole rows per batch, so the batches of a range of rows are all full batches.
+         m_fftBatchSize -= m_fftBatchSize % m_fftsPerRow;
       }
+
+      createWorkers(config, workerPool);
    }
    catch(...)
    {
       m_fftSize = 0;
       m_numFfts = 0;
+      m_numRawFfts = 0;
    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-FileToHeatMap<tSampType>::~FileToHeatMap()
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::initScaling(const tFileToHeatMapConfig& config)
+{
+   // Determine Max FFT value
+   m_normalizeHeatMap = config.normalizeHeatMap;
+   m_fastPngEncode = config.fastPngEncode;
+   if(std::isfinite(config.maxLevelDb))
+      m_fftToRgb_max_dB = config.maxLevelDb; // Use the user specified value.
+   else if(std::is_floating_point<tSampType>())
+      m_fftToRgb_max_dB = 0; // Floating point values could be anything. Set max to 0 dB
+   else
+      m_fftToRgb_max_dB = 20.0 * log10(double(std::numeric_limits<tSampType>::max())); // Set to max
+
+   m_fftToRgb_range_dB = config.rangeDb;
+   if(!std::isfinite(m_fftToRgb_range_dB) || m_fftToRgb_range_dB <= 0 || m_fftToRgb_range_dB > 1000) // Make sure the value makes sense.
+   {
+      m_fftToRgb_range_dB = 100;
+   }
+
+   // Auto scaling needs all the dB values before the scale is known, just like normalizing.
+   m_autoScale = config.autoScale;
+   m_autoScaleFloor = config.autoScaleFloor;
+   m_autoScaleTop = config.autoScaleTop;
+   if(m_autoScale)
+      m_normalizeHeatMap = false;
+   m_storeLevels = !m_normalizeHeatMap && !m_autoScale && !config.storeDb;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::createWorkers(const tFileToHeatMapConfig& config, std::shared_ptr<WorkerPool> workerPool)
+{
+   // Create the Worker Threads (unless a pool was passed in) and their Params. The threads are reused for every call to genHeatMap.
+   if(workerPool != nullptr)
+      m_numThreads = workerPool->getNumThreads();
+   if(m_numThreads <= 0){m_numThreads = 1;}
+   if(workerPool != nullptr)
+      m_workerPool = workerPool;
+   else
+      m_workerPool.reset(new WorkerPool(m_numThreads, config.workerAffinity));
+
+   // Each worker's params can be allocated by the worker itself, so its buffers are in the
+   // worker's local memory (NUMA first touch).
+   m_numaFirstTouch = config.numaFirstTouch;
+   m_fftThreadParams.resize(m_numThreads);
+   auto createParam = [this](size_t workerIndex)
+   {
+      m_fftThreadParams[workerIndex] = std::make_shared<tFftParam>(m_fftSize, m_fftBatchSize, m_mappedFile != nullptr);
+   };
+   if(m_numaFirstTouch)
+      m_workerPool->runOnAllWorkers(createParam);
+   else
+   {
+      for(size_t i = 0; i < m_numThreads; ++i)
+         createParam(i);
+   }
+
+   m_fft_dB.setHugePages(config.hugePages);
+   m_fftLevel.setHugePages(config.hugePages);
+   m_rgb.setHugePages(config.hugePages);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+FileToHeatMap<tSampType, tFftType>::~FileToHeatMap()
 {
    
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-void FileToHeatMap<tSampType>::genHeatMap()
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::genHeatMap()
+{
+   if(m_workerPool == nullptr)
+      return; // Construction failed.
+
+   // The heat map isn't touched here, each page is placed in memory when a worker first writes it.
+   size_t rowBytes;
+   size_t pageSize;
+   if(m_storeLevels)
+   {
+      m_fftLevel.allocate(m_numFfts*m_numBins);
+      if(m_fftLevel.size() < m_numFfts*m_numBins)
+         return; // Out of memory.
+      rowBytes = m_numBins*sizeof(uint8_t);
+      pageSize = m_fftLevel.getPageSize();
+   }
+   else
+   {
+      m_fft_dB.allocate(m_numFfts*m_numBins);
+      if(m_fft_dB.size() < m_numFfts*m_numBins)
+         return; // Out of memory.
+      m_dB = m_fft_dB.data();
+      m_numDbStored = m_fft_dB.size();
+      rowBytes = m_numBins*sizeof(tFftType);
+      pageSize = m_fft_dB.getPageSize();
+   }
+   resetStats();
+
+   // The workers pull batches of rows from a lock free counter until all the rows are done. For
+   // NUMA first touch the batches are whole pages, so every page is written by a single worker
+   // (and so ends up on that worker's node).
+   size_t rowsPerChunk = std::max(size_t(1), m_fftBatchSize / m_fftsPerRow);
+   if(m_numaFirstTouch)
+   {
+      // The smallest number of rows that is a whole number of pages is lcm(rowBytes, pageSize) / rowBytes.
+      rowBytes = std::max(size_t(1), rowBytes);
+      size_t rowsPerPages = std::lcm(rowBytes, std::max(size_t(1), pageSize)) / rowBytes;
+      if(rowsPerPages*m_numThreads <= m_numFfts) // Otherwise some workers wouldn't get any rows, leave the chunks as they are.
+         rowsPerChunk = (rowsPerChunk + rowsPerPages - 1) / rowsPerPages * rowsPerPages;
+   }
+   m_workerPool->parallelFor(m_numFfts, rowsPerChunk, [this](size_t workerIndex, size_t beginRow, size_t endRow)
+   {
+      auto& fftParam = m_fftThreadParams[workerIndex];
+      if(m_profiler != nullptr)
+         m_profiler->queueDepth(Profiler::E_QUEUE_ROWS, m_numFfts - endRow);
+      if(m_storeLevels)
+         processRows(fftParam, beginRow, endRow, nullptr, &m_fftLevel[beginRow*m_numBins]);
+      else
+         processRows(fftParam, beginRow, endRow, &m_fft_dB[beginRow*m_numBins], nullptr);
+   });
+
+   mergeStats();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+size_t FileToHeatMap<tSampType, tFftType>::genHeatMapPngSplit(const std::string& savePathNoExt, size_t maxNumFftsPerFile, bool rotate, size_t firstFile)
 {
-   std::unique_lock<std::mutex> lock(m_threadMutex);
-   for(size_t fftNum = 0; fftNum < m_numFfts; ++fftNum)
+   // The FFTs go straight to color levels, which needs the scaling up front (not normalized or auto
+   // scaled) and leaves no dB values to store (not storeDb, nor rendering from a dB cache).
+   if(m_workerPool == nullptr || !m_storeLevels || maxNumFftsPerFile == 0)
+      return firstFile; // Construction failed or invalid settings.
+
+   fpng::fpng_init();
+   resetStats();
+
+   // A file is complete once all of its rows have all of their FFTs (the last row of the input can
+   // be missing some of its m_fftsPerRow FFTs).
+   size_t numFiles = (m_numFfts + maxNumFftsPerFile - 1) / maxNumFftsPerFile;
+   size_t numCompleteFiles = (m_numRawFfts / m_fftsPerRow) / maxNumFftsPerFile;
+   if(firstFile >= numFiles)
+      return std::max(firstFile, numCompleteFiles);
+
+   // The rows of each file are split into batches that are spread across all the workers, so even a
+   // single file keeps every worker busy. Whichever worker finishes the last batch of a file converts
+   // it to RGB and writes it. Files are generated 1 group of up to 'number of workers' files at a time,
+   // so only 1 file worth of FFTs per worker is ever in memory.
+   size_t numThreads = std::max(size_t(1), m_workerPool->getNumThreads());
+   size_t rowsPerChunk = std::max(size_t(1), m_fftBatchSize / m_fftsPerRow);
+   for(size_t groupFirstFile = firstFile; groupFirstFile < numFiles; groupFirstFile += numThreads)
    {
-      // Get the next available thread.
-      while(m_fftThreadsAvailable.size() == 0)
+      size_t numFilesInGroup = std::min(numThreads, numFiles - groupFirstFile);
+      std::vector<std::vector<uint8_t>> fileLevels(numFilesInGroup);
+      std::vector<std::atomic<size_t>> chunksRemaining(numFilesInGroup);
+      std::vector<size_t> fileChunkStart(numFilesInGroup+1, 0); // Index of each file's first batch of rows.
+      for(size_t i = 0; i < numFilesInGroup; ++i)
       {
-         m_threadCondVar.wait(lock);
+         size_t fftIndex = (groupFirstFile + i) * maxNumFftsPerFile;
+         size_t numFftsInThisFile = std::min(maxNumFftsPerFile, m_numFfts-fftIndex);
+         size_t numChunks = (numFftsInThisFile + rowsPerChunk - 1) / rowsPerChunk;
+         fileLevels[i].resize(numFftsInThisFile*m_numBins);
+         chunksRemaining[i] = numChunks;
+         fileChunkStart[i+1] = fileChunkStart[i] + numChunks;
       }
-      auto fftParam = m_fftThreadsAvailable.front();
-      m_fftThreadsAvailable.pop_front();
-    
-      // Read the bytes out of the file, then activate a thread for processing.
-      readFromFile(fftParam, fftNum);
-      fftParam->fftThread = std::thread(&FileToHeatMap::doFft, this, fftParam);
-      fftParam->fftThread.detach();
+
+      m_workerPool->parallelFor(fileChunkStart.back(), 1, [&](size_t workerIndex, size_t beginIndex, size_t endIndex)
+      {
+         auto& fftParam = m_fftThreadParams[workerIndex];
+         for(size_t chunkIndex = beginIndex; chunkIndex < endIndex; ++chunkIndex)
+         {
+            size_t i = std::upper_bound(fileChunkStart.begin(), fileChunkStart.end(), chunkIndex) - fileChunkStart.begin() - 1;
+            size_t fileIndex = groupFirstFile + i;
+            size_t fftIndex = fileIndex * maxNumFftsPerFile;
+            size_t numFftsInThisFile = fileLevels[i].size() / m_numBins;
+            size_t beginRow = (chunkIndex - fileChunkStart[i]) * rowsPerChunk;
+            size_t endRow = std::min(beginRow + rowsPerChunk, numFftsInThisFile);
+
+            // Run the FFTs for this batch of rows.
+            processRows(fftParam, fftIndex+beginRow, fftIndex+endRow, nullptr, &fileLevels[i][beginRow*m_numBins]);
+            if(--chunksRemaining[i] != 0)
+               continue; // Other batches of this file are still running.
+
+            // Convert FFT color levels to RGB and save the file.
+            size_t height = rotate ? m_numBins : numFftsInThisFile;
+            size_t width  = rotate ? numFftsInThisFile : m_numBins;
+            fftParam->fileRgb.resize(3*numFftsInThisFile*m_numBins);
+            levelToRgb(fileLevels[i].data(), numFftsInThisFile, rotate, 0, height, fftParam->fileRgb.data(), false); // Already running on a worker.
+            std::vector<uint8_t>().swap(fileLevels[i]); // Done with the levels.
+            std::string savePath = savePathNoExt + "_" + std::to_string(fileIndex) + ".png";
+            Profiler::Scope encodeScope(m_profiler.get(), Profiler::E_STAGE_ENCODE, fftParam->fileRgb.size(), 1);
+            fpng::fpng_encode_image_to_file(savePath.c_str(), fftParam->fileRgb.data(), width, height, 3, getFpngFlags());
+         }
+      });
    }
-   
-   // Wait until all thread have finished before returning.
-   while(m_fftThreadsAvailable.size() < m_numThreads)
+
+   mergeStats();
+   return numCompleteFiles;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::resetStats()
+{
+   for(auto& fftParam : m_fftThreadParams)
    {
-      m_threadCondVar.wait(lock);
+      fftParam->fftMaxMinNeedInit = true;
+      if(m_autoScale)
+         fftParam->dbHistogram.assign(DB_HIST_NUM_BINS, 0);
    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-void FileToHeatMap<tSampType>::readFromFile(std::shared_ptr<tFftParam> param, size_t fftNum)
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::mergeStats()
 {
-   m_fileStream.seekg(COMPLEX_SAMP_SIZE*fftNum*m_sampBetweenFfts+m_fileStartOffset, std::ios::beg);
-   m_fileStream.read(reinterpret_cast<char*>(param->iqSamples.data()), COMPLEX_SAMP_SIZE*m_fftSize);
-   param->fftWritePtr = &m_fft_dB[fftNum*m_fftSize];
+   m_fftMaxMinNeedInit = true;
+   for(auto& fftParam : m_fftThreadParams)
+   {
+      if(fftParam->fftMaxMinNeedInit)
+         continue; // This worker didn't process any FFTs.
+      if(m_fftMaxMinNeedInit)
+      {
+         m_fftMaxMinNeedInit = false;
+         m_fftMax_dB = fftParam->fftMax_dB;
+         m_fftMin_dB = fftParam->fftMin_dB;
+      }
+      else
+      {
+         if(fftParam->fftMax_dB > m_fftMax_dB)
+            m_fftMax_dB = fftParam->fftMax_dB;
+         if(fftParam->fftMin_dB < m_fftMin_dB)
+            m_fftMin_dB = fftParam->fftMin_dB;
+      }
+   }
+   if(m_autoScale)
+      mergeHistograms();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-void FileToHeatMap<tSampType>::doFft(std::shared_ptr<tFftParam> param)
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::mergeHistograms()
 {
-   // De-interleave / convert to double.
-   for(size_t i = 0; i < m_fftSize; ++i)
+   // Each worker counted its own dB values, add them all up. Then pick the scale from the percentiles.
+   m_dbHistogram.assign(DB_HIST_NUM_BINS, 0);
+   for(auto& fftParam : m_fftThreadParams)
    {
-      param->iSamples[i] = param->iqSamples[2*i+0];
-      param->qSamples[i] = param->iqSamples[2*i+1];
+      for(size_t i = 0; i < fftParam->dbHistogram.size(); ++i)
+         m_dbHistogram[i] += fftParam->dbHistogram[i];
    }
 
-   // Run the FFT.
-   complexFFT(m_threadMutex, param->iSamples, param->qSamples, param->fftRe, param->fftIm, m_fftWindow.data());
+   double floor_dB = getHistogramPercentile(m_autoScaleFloor);
+   double top_dB = getHistogramPercentile(m_autoScaleTop);
+   if(std::isfinite(floor_dB) && std::isfinite(top_dB))
+   {
+      m_fftToRgb_max_dB = top_dB;
+      m_fftToRgb_range_dB = std::max(top_dB - floor_dB, 1.0 / DB_HIST_BINS_PER_DB);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-   // Store FFT Magnitude information.
-   double* fftRe = param->fftRe.data();
-   double* fftIm = param->fftIm.data();
-   double* fftDbPtr = param->fftWritePtr;
-   double fftMax = 0;
-   double fftMin = 0;
+template<typename tSampType, typename tFftType>
+double FileToHeatMap<tSampType, tFftType>::getHistogramPercentile(double percentile)
+{
+   uint64_t total = 0;
+   for(auto count : m_dbHistogram)
+      total += count;
+   if(total == 0)
+      return std::numeric_limits<double>::quiet_NaN();
+
+   // Center of the bin the percentile falls in.
+   double target = std::min(std::max(percentile, 0.0), 100.0) / 100.0 * double(total);
+   uint64_t cumulative = 0;
+   size_t bin = 0;
+   for(; bin < DB_HIST_NUM_BINS - 1; ++bin)
+   {
+      cumulative += m_dbHistogram[bin];
+      if(double(cumulative) >= target && cumulative > 0)
+         break;
+   }
+   return DB_HIST_MIN + (double(bin) + 0.5) / DB_HIST_BINS_PER_DB;
+}
 
-   // Fill in index 0 outside of the for loop so we can initialize min / max.
-   fftDbPtr[0] = 10.0 * log10(fftRe[0] * fftRe[0] + fftIm[0] * fftIm[0]);
-   fftMax = fftDbPtr[0];
-   fftMin = fftDbPtr[0];
+////////////////////////////////////////////////////////////////////////////////
 
-   for(size_t i = 0; i < m_fftSize; ++i)
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::readFromFile(std::shared_ptr<tFftParam> param, size_t fftNum, size_t numFfts)
+{
+   Profiler::Scope readScope(m_profiler.get(), Profiler::E_STAGE_READ, COMPLEX_SAMP_SIZE*m_fftSize*numFfts, numFfts);
+   if(m_mappedFile != nullptr)
+   {
+      // Point directly at the samples in the memory mapped file (no copy, no lock).
+      const uint8_t* fileData = m_mappedFile->getData();
+      for(size_t i = 0; i < numFfts; ++i)
+         param->iqFramePtrs[i] = reinterpret_cast<const tSampType*>(fileData + COMPLEX_SAMP_SIZE*(fftNum+i)*m_sampBetweenFfts+m_fileStartOffset);
+
+      // With gaps between the FFTs the mapping has no read ahead. This batch's samples are needed
+      // right away, so start reading in the next batch's samples while this batch's FFTs run.
+      if(m_sampBetweenFfts > m_fftSize)
+      {
+         size_t endFft = std::min(fftNum + 2*numFfts, m_numRawFfts);
+         for(size_t nextFft = fftNum + numFfts; nextFft < endFft; ++nextFft)
+            m_mappedFile->willNeed(COMPLEX_SAMP_SIZE*nextFft*m_sampBetweenFfts+m_fileStartOffset, COMPLEX_SAMP_SIZE*m_fftSize);
+      }
+   }
+   else
    {
-      fftDbPtr[i] = 10.0 * log10(fftRe[i] * fftRe[i] + fftIm[i] * fftIm[i]);
-      if(fftDbPtr[i] > fftMax)
-         fftMax = fftDbPtr[i];
-      else if(fftDbPtr[i] < fftMin)
-         fftMin = fftDbPtr[i];
+      std::unique_lock<std::mutex> lock(m_threadMutex, std::defer_lock); // All the workers share the same file stream.
+      {
+         Profiler::Scope lockScope(m_profiler.get(), Profiler::E_STAGE_LOCK_WAIT);
+         lock.lock();
+      }
+      for(size_t i = 0; i < numFfts; ++i)
+      {
+         m_fileStream.seekg(COMPLEX_SAMP_SIZE*(fftNum+i)*m_sampBetweenFfts+m_fileStartOffset, std::ios::beg);
+         m_fileStream.read(reinterpret_cast<char*>(&param->iqSamples[2*m_fftSize*i]), COMPLEX_SAMP_SIZE*m_fftSize);
+         param->iqFramePtrs[i] = &param->iqSamples[2*m_fftSize*i];
+      }
    }
+   param->numFfts = numFfts;
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-   // Store stats and put the thread in the finish list.
-   std::lock_guard<std::mutex> lock(m_threadMutex);
-   if(m_fftMaxMinNeedInit)
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::processRows(std::shared_ptr<tFftParam> param, size_t beginRow, size_t endRow, tFftType* dBWritePtr, uint8_t* levelWritePtr)
+{
+   // Run the FFTs of all the rows in batches. A batch can span rows, doFft writes each row as soon as
+   // all of its FFTs are done.
+   param->firstRow = beginRow;
+   param->dBRowsPtr = dBWritePtr;
+   param->levelRowsPtr = levelWritePtr;
+   size_t beginFft = beginRow*m_fftsPerRow;
+   size_t endFft = std::min(endRow*m_fftsPerRow, m_numRawFfts);
+   for(size_t fftIndex = beginFft; fftIndex < endFft; fftIndex += m_fftBatchSize)
    {
-      m_fftMaxMinNeedInit = false;
-      m_fftMax_dB = fftMax;
-      m_fftMin_dB = fftMin;
+      readFromFile(param, fftIndex, std::min(m_fftBatchSize, endFft-fftIndex));
+      param->firstFft = fftIndex;
+      doFft(param);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::doFft(std::shared_ptr<tFftParam> param)
+{
+   Profiler::Scope fftScope(m_profiler.get(), Profiler::E_STAGE_FFT, 0, param->numFfts);
+
+   // Full batches run on the batch plan. The FFTs of a short batch (the tail of a range of FFTs) are
+   // run one at a time on the single FFT plan, so a tail never needs a plan (i.e. FFTW planning) of its own.
+   const size_t fftsPerExecute = param->numFfts == m_fftBatchSize ? m_fftBatchSize : 1;
+   ComplexFftBatch<tFftType>& fftBatch = ComplexFftBatch<tFftType>::get(m_fftSize, fftsPerExecute);
+   const tFftType* window = m_fftWindow.data();
+
+   // The window already normalized by the FFT Size and, for even FFT sizes, put DC in the center.
+   // Odd FFT sizes still need the FFT result swapped.
+   const size_t numEndFftPointsToSwap = m_fftShiftByModulation ? 0 : m_fftSize >> 1; // round down
+   const size_t numBeginFftPointsToSwap = m_fftSize - numEndFftPointsToSwap;
+   const tFftType dBOffset = 0;
+   tFftType fftMax = -std::numeric_limits<tFftType>::infinity();
+   tFftType fftMin = std::numeric_limits<tFftType>::infinity();
+   const double MIN_DB_FS_VAL = m_fftToRgb_max_dB - m_fftToRgb_range_dB;
+   const double DELTA_DB_FS_VAL = m_fftToRgb_max_dB - MIN_DB_FS_VAL;
+   tFftType* dBRowsPtr = param->dBRowsPtr;
+   uint8_t* levelRowsPtr = param->levelRowsPtr;
+
+   for(size_t executeStart = 0; executeStart < param->numFfts; executeStart += fftsPerExecute)
+   {
+      // Convert to tFftType and apply the window, writing directly into the FFTW input buffer.
+      for(size_t i = 0; i < fftsPerExecute; ++i)
+      {
+         const tSampType* iqSamples = param->iqFramePtrs[executeStart + i];
+         tFftType* fftIn = fftBatch.getInput(i);
+         convertAndWindow(iqSamples, window, fftIn, 2*m_fftSize);
+         if(std::is_floating_point<tSampType>())
+            fixStartNanComplex(fftIn, m_fftSize);
+      }
+
+      fftBatch.execute();
+
+      // Store FFT Magnitude information.
+      for(size_t i = 0; i < fftsPerExecute; ++i)
+      {
+         const size_t fftIndex = param->firstFft + executeStart + i; // Index of the FFT in the whole heat map.
+         const tFftType* fftOut = fftBatch.getOutput(i);
+         if(m_combinePower)
+         {
+            // Combine the power into the current row. It is converted to dB once the row is done (finishRow).
+            tFftType* rowPower = param->rowPower.data();
+            bool first = param->rowNumFfts == 0;
+            if(numEndFftPointsToSwap > 0)
+               combinePower(fftOut + 2*numBeginFftPointsToSwap, rowPower, numEndFftPointsToSwap, m_rowCombine, first);
+            combinePower(fftOut, rowPower + numEndFftPointsToSwap, numBeginFftPointsToSwap, m_rowCombine, first);
+            ++param->rowNumFfts;
+            if((fftIndex + 1) % m_fftsPerRow == 0 || fftIndex + 1 == m_numRawFfts)
+            {
+               // Last FFT of the row (the last row of the input can be short), write the row.
+               size_t rowOffset = fftIndex / m_fftsPerRow - param->firstRow;
+               param->fftWritePtr = dBRowsPtr ? dBRowsPtr + m_numBins*rowOffset : nullptr;
+               param->levelWritePtr = levelRowsPtr ? levelRowsPtr + m_numBins*rowOffset : nullptr;
+               finishRow(param);
+            }
+            continue;
+         }
+
+         // Not combining, so every FFT is its own row.
+         const size_t rowOffset = fftIndex - param->firstRow;
+         tFftType* fftDbPtr = m_storeLevels ? param->fft_dB.data() : dBRowsPtr + m_fftSize*rowOffset;
+         if(numEndFftPointsToSwap > 0)
+            powerToDb(fftOut + 2*numBeginFftPointsToSwap, fftDbPtr, numEndFftPointsToSwap, dBOffset, fftMin, fftMax);
+         powerToDb(fftOut, fftDbPtr + numEndFftPointsToSwap, numBeginFftPointsToSwap, dBOffset, fftMin, fftMax);
+         if(m_storeLevels)
+            dbToLevel(fftDbPtr, levelRowsPtr + m_fftSize*rowOffset, m_fftSize, MIN_DB_FS_VAL, DELTA_DB_FS_VAL);
+         else if(m_autoScale)
+            updateHistogram(param, fftDbPtr, m_fftSize);
+      }
+   }
+   if(!m_combinePower)
+      updateStats(param, fftMin, fftMax);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::finishRow(std::shared_ptr<tFftParam> param)
+{
+   if(param->rowNumFfts == 0)
+      return;
+
+   // Mean is a sum up to this point, divide by the number of FFTs in the row.
+   const tFftType dBOffset = m_rowCombine == E_COMBINE_MEAN ? tFftType(-10.0 * log10(double(param->rowNumFfts))) : 0;
+   tFftType fftMax = -std::numeric_limits<tFftType>::infinity();
+   tFftType fftMin = std::numeric_limits<tFftType>::infinity();
+   tFftType* fftDbPtr = m_storeLevels ? param->fft_dB.data() : param->fftWritePtr;
+   const tFftType* power = param->rowPower.data();
+   if(m_numBins != m_fftSize)
+   {
+      reduceBins(power, param->reducedPower.data(), m_fftSize, m_numBins, m_binReduce);
+      power = param->reducedPower.data();
+   }
+   linearToDb(power, fftDbPtr, m_numBins, dBOffset, fftMin, fftMax);
+   if(m_storeLevels)
+   {
+      const double MIN_DB_FS_VAL = m_fftToRgb_max_dB - m_fftToRgb_range_dB;
+      const double DELTA_DB_FS_VAL = m_fftToRgb_max_dB - MIN_DB_FS_VAL;
+      dbToLevel(fftDbPtr, param->levelWritePtr, m_numBins, MIN_DB_FS_VAL, DELTA_DB_FS_VAL);
+   }
+   else if(m_autoScale)
+   {
+      updateHistogram(param, fftDbPtr, m_numBins);
+   }
+   param->rowNumFfts = 0;
+   updateStats(param, fftMin, fftMax);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::updateStats(std::shared_ptr<tFftParam> param, tFftType fftMin, tFftType fftMax)
+{
+   // Store this worker's stats (no lock needed, they are merged after all the FFTs are done).
+   if(param->fftMaxMinNeedInit)
+   {
+      param->fftMaxMinNeedInit = false;
+      param->fftMax_dB = fftMax;
+      param->fftMin_dB = fftMin;
    }
    else
    {
-      if(fftMax > m_fftMax_dB)
-         m_fftMax_dB = fftMax;
-      else if(fftMin < m_fftMin_dB)
-         m_fftMin_dB = fftMin;
+      if(fftMax > param->fftMax_dB)
+         param->fftMax_dB = fftMax;
+      if(fftMin < param->fftMin_dB)
+         param->fftMin_dB = fftMin;
    }
-   m_fftThreadsAvailable.push_back(param);
-   m_threadCondVar.notify_all();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-void FileToHeatMap<tSampType>::fftToRgb(bool rotate, size_t fftOffset, size_t numFFTs)
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::updateHistogram(std::shared_ptr<tFftParam> param, const tFftType* fft_dB, size_t num)
 {
-   const double MAX_DB_FS_VAL = m_normalizeHeatMap ? m_fftMax_dB : m_fftToRgb_max_dB;
-   const double MIN_DB_FS_VAL = MAX_DB_FS_VAL - m_fftToRgb_range_dB;
-   const double DELTA_DB_FS_VAL = MAX_DB_FS_VAL - MIN_DB_FS_VAL;
+   // Per worker histogram, no lock needed (merged after all the FFTs are done).
+   uint64_t* histogram = param->dbHistogram.data();
+   const tFftType binsPerDb = tFftType(DB_HIST_BINS_PER_DB);
+   const tFftType histMin = tFftType(DB_HIST_MIN);
+   const tFftType maxBin = tFftType(DB_HIST_NUM_BINS - 1);
+   for(size_t i = 0; i < num; ++i)
+   {
+      tFftType bin = (fft_dB[i] - histMin) * binsPerDb;
+      bin = bin > tFftType(0) ? bin : tFftType(0); // Also catches NaN
+      bin = bin < maxBin ? bin : maxBin;
+      ++histogram[size_t(bin)];
+   }
+}
 
-   if(fftOffset >= m_numFfts)
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::fftToRgb(bool rotate, size_t fftOffset, size_t numFFTs)
+{
+   size_t numStored = getNumStored();
+   if(fftOffset >= m_numFfts || numStored < m_numFfts*m_numBins)
    {
-      m_rgb.resize(0);
-      return; // Invalid offset value. Exit early
+      m_rgb.clear();
+      return; // Invalid offset value (or genHeatMap hasn't been called). Exit early
    }
    if(numFFTs == 0 || numFFTs > (m_numFfts-fftOffset))
       numFFTs = (m_numFfts-fftOffset);
 
-   m_rgb.resize(3*numFFTs*m_fftSize); // Allocate memory to store RGB bytes
-   uint8_t* rgbWritePtr = m_rgb.data();
-   size_t fftBinIndex = 0;
-   size_t fftIndex = fftOffset;
-   size_t numPixels = numFFTs*m_fftSize;
-   for(size_t outIndex = 0; outIndex < numPixels; ++outIndex)
-   {
-      size_t inIndex = rotate ? m_fftSize*fftIndex+fftBinIndex : outIndex+fftOffset*m_fftSize;
-      double normVal = (m_fft_dB[inIndex] - MIN_DB_FS_VAL) / DELTA_DB_FS_VAL;
-      if(normVal > 1.0){normVal = 1.0;}
-      if(normVal < 0.0){normVal = 0.0;}
-      uint8_t fftNormVal = uint8_t((1.0-normVal)*255.0);
-
-      // Lookup table based
-      extern RgbColor LevelToRgbLookup[256];
-      rgbWritePtr[3*outIndex+0] = LevelToRgbLookup[fftNormVal].r;
-      rgbWritePtr[3*outIndex+1] = LevelToRgbLookup[fftNormVal].g;
-      rgbWritePtr[3*outIndex+2] = LevelToRgbLookup[fftNormVal].b;
-      
-      if(rotate)
+   m_rgb.allocate(3*numFFTs*m_numBins); // Allocate memory to store RGB bytes
+   if(m_rgb.size() < 3*numFFTs*m_numBins)
+      return; // Out of memory.
+   size_t numRows = rotate ? m_numBins : numFFTs;
+   if(m_storeLevels)
+      levelToRgb(&m_fftLevel[fftOffset*m_numBins], numFFTs, rotate, 0, numRows, m_rgb.data(), true);
+   else
+      fftToRgb(&m_dB[fftOffset*m_numBins], numFFTs, rotate, 0, numRows, m_rgb.data(), true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::fftToRgb(const tFftType* fft_dB, size_t numFFTs, bool rotate, size_t beginRow, size_t endRow, uint8_t* rgbWritePtr, bool useWorkerPool)
+{
+   const double MAX_DB_FS_VAL = m_normalizeHeatMap ? m_fftMax_dB : m_fftToRgb_max_dB;
+   const double MIN_DB_FS_VAL = MAX_DB_FS_VAL - m_fftToRgb_range_dB;
+   const double DELTA_DB_FS_VAL = MAX_DB_FS_VAL - MIN_DB_FS_VAL;
+   renderRgb(numFFTs, rotate, beginRow, endRow, rgbWritePtr, useWorkerPool, [&](size_t inIndex){return dbToLevel(fft_dB[inIndex], MIN_DB_FS_VAL, DELTA_DB_FS_VAL);});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::levelToRgb(const uint8_t* fftLevel, size_t numFFTs, bool rotate, size_t beginRow, size_t endRow, uint8_t* rgbWritePtr, bool useWorkerPool)
+{
+   renderRgb(numFFTs, rotate, beginRow, endRow, rgbWritePtr, useWorkerPool, [&](size_t inIndex){return fftLevel[inIndex];});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+template<typename tFunc>
+void FileToHeatMap<tSampType, tFftType>::renderRgb(size_t numFFTs, bool rotate, size_t beginRow, size_t endRow, uint8_t* rgbWritePtr, bool useWorkerPool, tFunc getLevel)
+{
+   extern RgbColor LevelToRgbLookup[256];
+   static constexpr size_t TILE_SIZE = 64;
+   const size_t width = rotate ? numFFTs : m_numBins;
+
+   // Renders output rows [rowBegin, rowEnd). Each row range writes to its own pixels, so
+   // row ranges can be rendered in parallel.
+   auto renderRows = [&](size_t rowBegin, size_t rowEnd)
+   {
+      Profiler::Scope renderScope(m_profiler.get(), Profiler::E_STAGE_RENDER, 3*(rowEnd - rowBegin)*width, (rowEnd - rowBegin)*width);
+      if(!rotate)
+      {
+         uint8_t* rgbPtr = rgbWritePtr + 3*(rowBegin - beginRow)*width;
+         size_t endIndex = rowEnd*m_numBins;
+         for(size_t inIndex = rowBegin*m_numBins; inIndex < endIndex; ++inIndex, rgbPtr += 3)
+         {
+            uint8_t fftNormVal = getLevel(inIndex);
+            rgbPtr[0] = LevelToRgbLookup[fftNormVal].r;
+            rgbPtr[1] = LevelToRgbLookup[fftNormVal].g;
+            rgbPtr[2] = LevelToRgbLookup[fftNormVal].b;
+         }
+         return;
+      }
+
+      // Rotated, i.e. each output row is a single FFT bin across all the FFTs. Walking the input by
+      // column would touch a new cache line (and often a new page) for every pixel, so transpose
+      // in tiles that fit in the L1 cache instead.
+      for(size_t fftTileStart = 0; fftTileStart < numFFTs; fftTileStart += TILE_SIZE)
       {
-         if(++fftIndex >= (fftOffset+numFFTs))
+         size_t fftTileEnd = std::min(fftTileStart + TILE_SIZE, numFFTs);
+         for(size_t binTileStart = rowBegin; binTileStart < rowEnd; binTileStart += TILE_SIZE)
          {
-            fftIndex = fftOffset;
-            ++fftBinIndex;
+            size_t binTileEnd = std::min(binTileStart + TILE_SIZE, rowEnd);
+            for(size_t fftBinIndex = binTileStart; fftBinIndex < binTileEnd; ++fftBinIndex)
+            {
+               uint8_t* rgbRow = rgbWritePtr + 3*(fftBinIndex - beginRow)*width;
+               for(size_t fftIndex = fftTileStart; fftIndex < fftTileEnd; ++fftIndex)
+               {
+                  uint8_t fftNormVal = getLevel(m_numBins*fftIndex+fftBinIndex);
+                  rgbRow[3*fftIndex+0] = LevelToRgbLookup[fftNormVal].r;
+                  rgbRow[3*fftIndex+1] = LevelToRgbLookup[fftNormVal].g;
+                  rgbRow[3*fftIndex+2] = LevelToRgbLookup[fftNormVal].b;
+               }
+            }
          }
       }
+   };
+
+   // Split the rows across the workers (whole tiles when rotated).
+   if(useWorkerPool && m_workerPool != nullptr && m_workerPool->getNumThreads() > 1)
+   {
+      size_t rowsPerChunk = rotate ? TILE_SIZE : 4*TILE_SIZE;
+      m_workerPool->parallelFor(endRow - beginRow, rowsPerChunk, [&](size_t workerIndex, size_t beginIndex, size_t endIndex)
+      {
+         renderRows(beginRow + beginIndex, beginRow + endIndex);
+      });
+   }
+   else
+   {
+      renderRows(beginRow, endRow);
    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-void FileToHeatMap<tSampType>::saveBmp(const std::string& savePath, bool rotate)
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::saveBmp(const std::string& savePath, bool rotate)
 {
    fftToRgb(rotate);
-   size_t height = rotate ? m_fftSize : m_numFfts;
-   size_t width  = rotate ? m_numFfts : m_fftSize;
+   size_t height = rotate ? m_numBins : m_numFfts;
+   size_t width  = rotate ? m_numFfts : m_numBins;
+   Profiler::Scope encodeScope(m_profiler.get(), Profiler::E_STAGE_ENCODE, m_rgb.size(), 1);
    bmp::Bitmap image(width, height);
    size_t i = 0;
    for (bmp::Pixel &pixel: image)
@@ -409,43 +1081,323 @@ void FileToHeatMap<tSampType>::saveBmp(const std::string& savePath, bool rotate)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-void FileToHeatMap<tSampType>::savePng(const std::string& savePath, bool rotate)
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::savePng(const std::string& savePath, bool rotate)
 {
-   fftToRgb(rotate);
+   size_t numStored = getNumStored();
+   if(m_workerPool == nullptr || numStored < m_numFfts*m_numBins)
+      return; // Construction failed or genHeatMap hasn't been called.
+
+   size_t height = rotate ? m_numBins : m_numFfts;
+   size_t width  = rotate ? m_numFfts : m_numBins;
+   size_t numThreads = m_workerPool->getNumThreads();
+   // Render and compress a block of rows at a time (about 1 MB of RGB per worker), so the
+   // full RGB image is never in memory.
+   size_t rowsPerBlock = std::max(size_t(1), (numThreads << 20) / std::max(size_t(1), 3*width));
+   WorkerPool* workerPool = numThreads > 1 ? m_workerPool.get() : nullptr; // A single worker compresses the strips itself.
+
+   PngStreamWriter png(savePath, width, height, m_fastPngEncode);
+   std::vector<uint8_t> rgbBlock;
+   for(size_t beginRow = 0; beginRow < height && png.isValid(); beginRow += rowsPerBlock)
+   {
+      size_t endRow = std::min(beginRow + rowsPerBlock, height);
+      rgbBlock.resize(3*width*(endRow - beginRow));
+      if(m_storeLevels)
+         levelToRgb(m_fftLevel.data(), m_numFfts, rotate, beginRow, endRow, rgbBlock.data(), true);
+      else
+         fftToRgb(m_dB, m_numFfts, rotate, beginRow, endRow, rgbBlock.data(), true);
+      Profiler::Scope encodeScope(m_profiler.get(), Profiler::E_STAGE_ENCODE, rgbBlock.size());
+      png.writeRows(rgbBlock.data(), endRow - beginRow, workerPool);
+   }
+   Profiler::Scope encodeScope(m_profiler.get(), Profiler::E_STAGE_ENCODE, 0, 1);
+   png.finish();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::savePngSplit(const std::string& savePathNoExt, size_t maxNumFftsPerFile, bool rotate)
+{
+   size_t numStored = getNumStored();
+   if(m_workerPool == nullptr || maxNumFftsPerFile == 0 || numStored < m_numFfts*m_numBins)
+      return; // Construction failed, invalid settings or genHeatMap hasn't been called.
+
+   size_t numFiles = (m_numFfts + maxNumFftsPerFile - 1) / maxNumFftsPerFile;
+   if(numFiles == 1)
+   {
+      // Only 1 file, split the encoding of that file across the workers.
+      savePng(savePathNoExt + "_0.png", rotate);
+      return;
+   }
+
+   // Each worker renders and encodes an entire file at a time.
    fpng::fpng_init();
-   size_t height = rotate ? m_fftSize : m_numFfts;
-   size_t width  = rotate ? m_numFfts : m_fftSize;
-   fpng::fpng_encode_image_to_file(savePath.c_str(), m_rgb.data(), width, height, 3, fpng::FPNG_ENCODE_SLOWER);
+   m_workerPool->parallelFor(numFiles, 1, [&](size_t workerIndex, size_t beginFile, size_t endFile)
+   {
+      auto& fftParam = m_fftThreadParams[workerIndex];
+      for(size_t fileIndex = beginFile; fileIndex < endFile; ++fileIndex)
+      {
+         // Determine how many FFTs to put in this file (i.e. the last file might be smaller than maxNumFftsPerFile)
+         size_t fftIndex = fileIndex * maxNumFftsPerFile;
+         size_t numFftsInThisFile = std::min(maxNumFftsPerFile, m_numFfts-fftIndex);
+
+         // Convert FFT Magnatude values to RGB
+         fftParam->fileRgb.resize(3*numFftsInThisFile*m_numBins);
+         size_t height = rotate ? m_numBins : numFftsInThisFile;
+         size_t width  = rotate ? numFftsInThisFile : m_numBins;
+         if(m_storeLevels)
+            levelToRgb(&m_fftLevel[fftIndex*m_numBins], numFftsInThisFile, rotate, 0, height, fftParam->fileRgb.data(), false);
+         else
+            fftToRgb(&m_dB[fftIndex*m_numBins], numFftsInThisFile, rotate, 0, height, fftParam->fileRgb.data(), false);
+
+         // Save the file.
+         std::string savePath = savePathNoExt + "_" + std::to_string(fileIndex) + ".png";
+         Profiler::Scope encodeScope(m_profiler.get(), Profiler::E_STAGE_ENCODE, fftParam->fileRgb.size(), 1);
+         fpng::fpng_encode_image_to_file(savePath.c_str(), fftParam->fileRgb.data(), width, height, 3, getFpngFlags());
+      }
+   });
+}
 
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void FileToHeatMap<tSampType, tFftType>::savePngPyramid(const std::string& saveDir, size_t tileSize, bool rotate)
+{
+   size_t numStored = getNumStored();
+   if(m_workerPool == nullptr || tileSize == 0 || numStored < m_numFfts*m_numBins)
+      return; // Construction failed, invalid settings or genHeatMap hasn't been called.
+
+   if(m_storeLevels)
+   {
+      const uint8_t* fftLevel = m_fftLevel.data();
+      savePngPyramid(saveDir, tileSize, rotate, [=](size_t inIndex){return fftLevel[inIndex];});
+   }
+   else
+   {
+      const double MAX_DB_FS_VAL = m_normalizeHeatMap ? m_fftMax_dB : m_fftToRgb_max_dB;
+      const double MIN_DB_FS_VAL = MAX_DB_FS_VAL - m_fftToRgb_range_dB;
+      const double DELTA_DB_FS_VAL = MAX_DB_FS_VAL - MIN_DB_FS_VAL;
+      const tFftType* fft_dB = m_dB;
+      savePngPyramid(saveDir, tileSize, rotate, [=](size_t inIndex){return dbToLevel(fft_dB[inIndex], MIN_DB_FS_VAL, DELTA_DB_FS_VAL);});
+   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template<typename tSampType>
-void FileToHeatMap<tSampType>::savePngSplit(const std::string& savePathNoExt, size_t maxNumFftsPerFile, bool rotate)
+template<typename tSampType, typename tFftType>
+template<typename tFunc>
+void FileToHeatMap<tSampType, tFftType>::savePngPyramid(const std::string& saveDir, size_t tileSize, bool rotate, tFunc getLevel)
 {
    fpng::fpng_init();
 
-   size_t fileIndex = 0;
-   size_t fftIndex = 0;
-   while(fftIndex < m_numFfts)
+   // Level 0 comes straight from the stored dB values / color levels. Every level above that is
+   // pooled from the level below it as color levels. dbToLevel maps higher dB values to lower
+   // color levels, so the max dB of a 2x2 block is the min of its color levels, i.e. pooling the
+   // 8 bit levels gives the same result as pooling in dB without keeping any extra dB values.
+   size_t numFFTs = m_numFfts;
+   size_t numBins = m_numBins;
+   savePyramidLevel(saveDir + "/0", numFFTs, numBins, tileSize, rotate, getLevel);
+
+   std::vector<uint8_t> prevLevel;
+   std::vector<uint8_t> pooledLevel;
+   for(size_t level = 1; std::max(numFFTs, numBins) > tileSize; ++level)
    {
-      // Determine how many FFTs to put in this file (i.e. the last file might be smaller than maxNumFftsPerFile)
-      size_t numFftsInThisFile = (fftIndex+maxNumFftsPerFile) <= m_numFfts ? maxNumFftsPerFile : (m_numFfts-fftIndex);
+      pooledLevel.resize(((numFFTs + 1) >> 1) * ((numBins + 1) >> 1));
+      if(level == 1)
+      {
+         poolPyramidLevel(numFFTs, numBins, pooledLevel.data(), getLevel);
+      }
+      else
+      {
+         const uint8_t* prevPtr = prevLevel.data();
+         poolPyramidLevel(numFFTs, numBins, pooledLevel.data(), [=](size_t inIndex){return prevPtr[inIndex];});
+      }
+      numFFTs = (numFFTs + 1) >> 1;
+      numBins = (numBins + 1) >> 1;
+      prevLevel.swap(pooledLevel);
 
-      // Convert FFT Magnatude values to RGB
-      fftToRgb(rotate, fftIndex, numFftsInThisFile);
+      const uint8_t* levelPtr = prevLevel.data();
+      savePyramidLevel(saveDir + "/" + std::to_string(level), numFFTs, numBins, tileSize, rotate, [=](size_t inIndex){return levelPtr[inIndex];});
+   }
+}
 
-      // Determine the image file parameters and save the file.
-      size_t height = rotate ? m_fftSize : numFftsInThisFile;
-      size_t width  = rotate ? numFftsInThisFile : m_fftSize;
-      std::string savePath = savePathNoExt + "_" + std::to_string(fileIndex) + ".png";
-      fpng::fpng_encode_image_to_file(savePath.c_str(), m_rgb.data(), width, height, 3, fpng::FPNG_ENCODE_SLOWER);
+////////////////////////////////////////////////////////////////////////////////
 
-      // Update loop parameters.
-      fftIndex += numFftsInThisFile;
-      ++fileIndex;
-   }
+template<typename tSampType, typename tFftType>
+template<typename tFunc>
+void FileToHeatMap<tSampType, tFftType>::savePyramidLevel(const std::string& levelDir, size_t numFFTs, size_t numBins, size_t tileSize, bool rotate, tFunc getLevel)
+{
+   extern RgbColor LevelToRgbLookup[256];
+   const size_t width  = rotate ? numFFTs : numBins;
+   const size_t height = rotate ? numBins : numFFTs;
+   const size_t numTilesX = (width + tileSize - 1) / tileSize;
+   const size_t numTilesY = (height + tileSize - 1) / tileSize;
+
+   // Make all the directories up front, the workers only write files.
+   std::error_code ec;
+   for(size_t tileX = 0; tileX < numTilesX; ++tileX)
+      std::filesystem::create_directories(levelDir + "/" + std::to_string(tileX), ec);
+
+   // Each worker renders and encodes an entire tile at a time.
+   m_workerPool->parallelFor(numTilesX*numTilesY, 1, [&](size_t workerIndex, size_t beginTile, size_t endTile)
+   {
+      auto& fftParam = m_fftThreadParams[workerIndex];
+      for(size_t tileIndex = beginTile; tileIndex < endTile; ++tileIndex)
+      {
+         size_t tileX = tileIndex % numTilesX;
+         size_t tileY = tileIndex / numTilesX;
+         size_t beginX = tileX*tileSize;
+         size_t beginY = tileY*tileSize;
+         size_t endX = std::min(beginX + tileSize, width);
+         size_t endY = std::min(beginY + tileSize, height);
+
+         fftParam->fileRgb.resize(3*tileSize*tileSize);
+         if(endX - beginX < tileSize || endY - beginY < tileSize)
+            std::fill(fftParam->fileRgb.begin(), fftParam->fileRgb.end(), 0);
+         {
+            Profiler::Scope renderScope(m_profiler.get(), Profiler::E_STAGE_RENDER, fftParam->fileRgb.size(), tileSize*tileSize);
+
+            // Walk the input in storage order (i.e. along the bins of each FFT), when rotated that
+            // means walking down a column of the tile.
+            size_t beginFft = rotate ? beginX : beginY;
+            size_t endFft   = rotate ? endX   : endY;
+            size_t beginBin = rotate ? beginY : beginX;
+            size_t endBin   = rotate ? endY   : endX;
+            for(size_t fftIndex = beginFft; fftIndex < endFft; ++fftIndex)
+            {
+               for(size_t binIndex = beginBin; binIndex < endBin; ++binIndex)
+               {
+                  size_t pixX = (rotate ? fftIndex : binIndex) - beginX;
+                  size_t pixY = (rotate ? binIndex : fftIndex) - beginY;
+                  uint8_t* rgbPtr = &fftParam->fileRgb[3*(pixY*tileSize + pixX)];
+                  uint8_t fftNormVal = getLevel(fftIndex*numBins + binIndex);
+                  rgbPtr[0] = LevelToRgbLookup[fftNormVal].r;
+                  rgbPtr[1] = LevelToRgbLookup[fftNormVal].g;
+                  rgbPtr[2] = LevelToRgbLookup[fftNormVal].b;
+               }
+            }
+         }
+
+         std::string savePath = levelDir + "/" + std::to_string(tileX) + "/" + std::to_string(tileY) + ".png";
+         Profiler::Scope encodeScope(m_profiler.get(), Profiler::E_STAGE_ENCODE, fftParam->fileRgb.size(), 1);
+         fpng::fpng_encode_image_to_file(savePath.c_str(), fftParam->fileRgb.data(), tileSize, tileSize, 3, getFpngFlags());
+      }
+   });
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+template<typename tFunc>
+void FileToHeatMap<tSampType, tFftType>::poolPyramidLevel(size_t numFFTs, size_t numBins, uint8_t* pooledLevel, tFunc getLevel)
+{
+   // Halves both axes, each output value is the min color level (i.e. the max dB value) of up to
+   // 2x2 input values (the last row / column is on its own when the size is odd).
+   const size_t numPooledFfts = (numFFTs + 1) >> 1;
+   const size_t numPooledBins = (numBins + 1) >> 1;
+   m_workerPool->parallelFor(numPooledFfts, 64, [&](size_t workerIndex, size_t beginFft, size_t endFft)
+   {
+      for(size_t pooledFft = beginFft; pooledFft < endFft; ++pooledFft)
+      {
+         size_t inRow0 = (2*pooledFft)*numBins;
+         size_t inRow1 = std::min(2*pooledFft+1, numFFTs-1)*numBins;
+         uint8_t* outPtr = pooledLevel + pooledFft*numPooledBins;
+         for(size_t pooledBin = 0; pooledBin < numPooledBins; ++pooledBin)
+         {
+            size_t inBin0 = 2*pooledBin;
+            size_t inBin1 = std::min(inBin0+1, numBins-1);
+            outPtr[pooledBin] = std::min(std::min(getLevel(inRow0 + inBin0), getLevel(inRow0 + inBin1)),
+                                         std::min(getLevel(inRow1 + inBin0), getLevel(inRow1 + inBin1)));
+         }
+      }
+   });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+bool FileToHeatMap<tSampType, tFftType>::saveDbCache(const std::string& cachePath)
+{
+   if(m_storeLevels || m_dB == nullptr || m_numDbStored < m_numFfts*m_numBins)
+      return false; // The dB values weren't stored (or genHeatMap hasn't been called).
+
+   tDbCacheHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, DB_CACHE_MAGIC, sizeof(header.magic));
+   header.version = DB_CACHE_VERSION;
+   header.fftTypeSize = sizeof(tFftType);
+   header.sampTypeSize = sizeof(tSampType);
+   header.sampTypeIsFloat = std::is_floating_point<tSampType>();
+   header.sampTypeIsSigned = std::is_signed<tSampType>();
+   header.fftSize = m_fftSize;
+   header.numBins = m_numBins;
+   header.numRows = m_numFfts;
+   header.sampBetweenFfts = m_sampBetweenFfts;
+   header.fftsPerRow = m_fftsPerRow;
+   header.sampleRate = m_sampleRate;
+   header.fftMax_dB = m_fftMax_dB;
+   header.fftMin_dB = m_fftMin_dB;
+   header.dataOffset = DB_CACHE_DATA_OFFSET;
+
+   std::ofstream cacheFile(cachePath, std::ios::binary);
+   std::vector<char> headerBytes(DB_CACHE_DATA_OFFSET, 0);
+   memcpy(headerBytes.data(), &header, sizeof(header));
+   cacheFile.write(headerBytes.data(), headerBytes.size());
+   cacheFile.write(reinterpret_cast<const char*>(m_dB), sizeof(tFftType)*m_numFfts*m_numBins);
+   return cacheFile.good();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+bool FileToHeatMap<tSampType, tFftType>::loadDbCache(const std::string& cachePath)
+{
+   if(m_workerPool == nullptr)
+      return false; // Construction failed.
+
+   std::unique_ptr<MappedFile> cacheFile(new MappedFile(cachePath));
+   if(!cacheFile->isValid() || cacheFile->getSize() < DB_CACHE_DATA_OFFSET)
+      return false;
+
+   tDbCacheHeader header;
+   memcpy(&header, cacheFile->getData(), sizeof(header));
+   if(memcmp(header.magic, DB_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != DB_CACHE_VERSION ||
+      header.fftTypeSize != sizeof(tFftType) || header.sampTypeSize != sizeof(tSampType) ||
+      header.sampTypeIsFloat != uint32_t(std::is_floating_point<tSampType>()) ||
+      header.sampTypeIsSigned != uint32_t(std::is_signed<tSampType>()) || header.dataOffset < sizeof(header) ||
+      (header.dataOffset % sizeof(tFftType)) != 0)
+      return false; // Not a cache file, or made with different types.
+   if(header.numBins == 0 || header.numRows > (cacheFile->getSize() - header.dataOffset) / (sizeof(tFftType)*header.numBins))
+      return false; // Truncated.
+
+   m_fftSize = header.fftSize;
+   m_numBins = header.numBins;
+   m_numFfts = header.numRows;
+   m_sampBetweenFfts = header.sampBetweenFfts;
+   m_fftsPerRow = header.fftsPerRow;
+   m_sampleRate = header.sampleRate;
+   m_fftMax_dB = header.fftMax_dB;
+   m_fftMin_dB = header.fftMin_dB;
+   m_fftMaxMinNeedInit = false;
+
+   // Rendering only needs the dB values, read them straight from the mapping.
+   cacheFile->setAccessPattern(MappedFile::E_ACCESS_SEQUENTIAL);
+   m_cacheFile = std::move(cacheFile);
+   m_storeLevels = false;
+   m_fft_dB.clear();
+   m_fftLevel.clear();
+   m_dB = reinterpret_cast<const tFftType*>(m_cacheFile->getData() + header.dataOffset);
+   m_numDbStored = m_numFfts*m_numBins;
+
+   // There are no FFTs to count the dB values as they are computed, build the histogram from the cache.
+   if(m_autoScale)
+   {
+      resetStats();
+      m_workerPool->parallelFor(m_numFfts, 64, [this](size_t workerIndex, size_t beginRow, size_t endRow)
+      {
+         updateHistogram(m_fftThreadParams[workerIndex], &m_dB[beginRow*m_numBins], (endRow - beginRow)*m_numBins);
+      });
+      mergeHistograms();
+   }
+   return true;
+}
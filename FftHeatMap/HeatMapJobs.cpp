@@ -0,0 +1,103 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "HeatMapJobs.h"
+
+static const char* DB_CACHE_EXTENSION = ".dbcache";
+
+bool isHeatMapOutput(const std::string& path)
+{
+   static const char* outputExtensions[] = {".png", ".bmp", ".state", ".tmp", DB_CACHE_EXTENSION};
+   std::string extension = std::filesystem::path(path).extension().string();
+   for(auto outputExtension : outputExtensions)
+   {
+      if(extension == outputExtension)
+         return true;
+   }
+   return false;
+}
+
+std::vector<tHeatMapJob> getHeatMapJobs(const std::string& inPath, const std::string& listPath, const std::string& outPath, bool dbCacheInput)
+{
+   std::vector<std::string> inPaths;
+   bool batch = true;
+   bool fromDirectory = false;
+   std::error_code ec;
+   if(listPath != "")
+   {
+      std::ifstream listFile(listPath);
+      std::string line;
+      while(std::getline(listFile, line))
+      {
+         if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+         if(line != "")
+            inPaths.push_back(line);
+      }
+   }
+   else if(std::filesystem::is_directory(inPath, ec))
+   {
+      fromDirectory = true;
+      std::filesystem::path outDir = outPath != "" ? std::filesystem::weakly_canonical(outPath, ec) : std::filesystem::path();
+      auto entry = std::filesystem::recursive_directory_iterator(inPath, ec);
+      for(; !ec && entry != std::filesystem::recursive_directory_iterator(); entry.increment(ec))
+      {
+         if(entry->is_directory() && !outDir.empty() && std::filesystem::weakly_canonical(entry->path(), ec) == outDir)
+         {
+            entry.disable_recursion_pending(); // The output directory is inside the input directory.
+            continue;
+         }
+         if(!entry->is_regular_file())
+            continue;
+         std::string path = entry->path().string();
+         bool isDbCache = entry->path().extension() == DB_CACHE_EXTENSION;
+         if(dbCacheInput ? isDbCache : !isHeatMapOutput(path))
+            inPaths.push_back(path);
+      }
+      std::sort(inPaths.begin(), inPaths.end());
+   }
+   else if(inPath != "")
+   {
+      inPaths.push_back(inPath);
+      batch = false;
+   }
+
+   std::vector<tHeatMapJob> jobs;
+   for(auto& path : inPaths)
+   {
+      tHeatMapJob job;
+      job.inPath = path;
+      if(!batch)
+         job.outPath = outPath;
+      else if(outPath == "")
+         job.outPath = path;
+      else if(fromDirectory)
+         job.outPath = (std::filesystem::path(outPath) / std::filesystem::path(path).lexically_relative(inPath)).string();
+      else
+         job.outPath = (std::filesystem::path(outPath) / std::filesystem::path(path).filename()).string();
+      if(job.outPath == "")
+         continue;
+      if(batch && outPath != "")
+         std::filesystem::create_directories(std::filesystem::path(job.outPath).parent_path(), ec);
+      jobs.push_back(job);
+   }
+   return jobs;
+}
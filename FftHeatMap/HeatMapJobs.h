@@ -0,0 +1,44 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+// An input file and where to write its heat map (without the extension).
+typedef struct tHeatMapJob
+{
+   std::string inPath;
+   std::string outPath;
+}tHeatMapJob;
+
+// True for the files the heat map tools write (images, incremental state, dB caches and temp files).
+bool isHeatMapOutput(const std::string& path);
+
+// Determines the input / output paths of every file to process. The input is a single file, every
+// file in a directory (and its sub directories) or every file listed (one per line) in a list file.
+// With multiple files, the output path is a directory (if empty, each output goes next to its input).
+// The outputs of a directory keep their path relative to the input directory, so inputs with the
+// same name in different sub directories don't overwrite each other.
+//
+// Files found in the input directory that were written by a previous run (see isHeatMapOutput) are
+// skipped, as is the output directory if it is inside the input directory. So running again, or
+// following a directory, never treats its own outputs as inputs. When 'dbCacheInput' is set the
+// inputs are dB cache files (render only), so only .dbcache files are picked up.
+std::vector<tHeatMapJob> getHeatMapJobs(const std::string& inPath, const std::string& listPath, const std::string& outPath, bool dbCacheInput = false);
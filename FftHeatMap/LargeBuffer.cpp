@@ -0,0 +1,116 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <unistd.h>
+#include <sys/mman.h>
+#include <fstream>
+#include <string>
+#include "LargeBuffer.h"
+
+static size_t RoundUp(size_t value, size_t multiple)
+{
+   return (value + multiple - 1) / multiple * multiple;
+}
+
+// Default huge page size, from /proc/meminfo (2 MB if it can't be read).
+static size_t ReadHugePageSize()
+{
+   std::ifstream memInfo("/proc/meminfo");
+   std::string name;
+   size_t value;
+   while(memInfo >> name >> value)
+   {
+      if(name == "Hugepagesize:")
+         return value << 10; // kB
+      memInfo.ignore(256, '\n');
+   }
+   return 2 << 20;
+}
+
+static size_t HugePageSize()
+{
+   static const size_t hugePageSize = ReadHugePageSize();
+   return hugePageSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t largeBufferPageSize(eHugePages hugePages)
+{
+   if(hugePages != E_HUGE_PAGES_OFF)
+      return HugePageSize();
+   long pageSize = sysconf(_SC_PAGESIZE);
+   return pageSize > 0 ? size_t(pageSize) : 4096;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void* largeBufferMap(size_t numBytes, eHugePages hugePages, size_t& numMappedBytes)
+{
+   numMappedBytes = 0;
+   if(numBytes == 0)
+      return nullptr;
+
+   const int prot = PROT_READ | PROT_WRITE;
+   const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+   if(hugePages == E_HUGE_PAGES_EXPLICIT)
+   {
+      size_t mapBytes = RoundUp(numBytes, HugePageSize());
+      void* data = mmap(nullptr, mapBytes, prot, flags | MAP_HUGETLB, -1, 0);
+      if(data != MAP_FAILED)
+      {
+         numMappedBytes = mapBytes;
+         return data;
+      }
+      // No huge pages reserved (see /proc/sys/vm/nr_hugepages), fall back to transparent huge pages.
+   }
+
+   if(hugePages == E_HUGE_PAGES_OFF)
+   {
+      size_t mapBytes = RoundUp(numBytes, largeBufferPageSize(hugePages));
+      void* data = mmap(nullptr, mapBytes, prot, flags, -1, 0);
+      if(data == MAP_FAILED)
+         return nullptr;
+      numMappedBytes = mapBytes;
+      return data;
+   }
+
+   // Transparent huge pages only back huge page aligned regions. Map an extra huge page and trim
+   // the ends so the buffer starts on a huge page boundary.
+   size_t hugePageSize = HugePageSize();
+   size_t mapBytes = RoundUp(numBytes, hugePageSize);
+   uint8_t* data = (uint8_t*)mmap(nullptr, mapBytes + hugePageSize, prot, flags, -1, 0);
+   if(data == (uint8_t*)MAP_FAILED)
+      return nullptr;
+   uint8_t* aligned = (uint8_t*)RoundUp(size_t(data), hugePageSize);
+   if(aligned > data)
+      munmap(data, aligned - data);
+   if(aligned + mapBytes < data + mapBytes + hugePageSize)
+      munmap(aligned + mapBytes, (data + mapBytes + hugePageSize) - (aligned + mapBytes));
+   madvise(aligned, mapBytes, MADV_HUGEPAGE);
+   numMappedBytes = mapBytes;
+   return aligned;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void largeBufferUnmap(void* data, size_t numMappedBytes)
+{
+   if(data != nullptr && numMappedBytes > 0)
+      munmap(data, numMappedBytes);
+}
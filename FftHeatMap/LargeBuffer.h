@@ -0,0 +1,93 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// What kind of pages back a LargeBuffer.
+typedef enum
+{
+   E_HUGE_PAGES_OFF,
+   E_HUGE_PAGES_TRANSPARENT, // Ask for transparent huge pages (madvise), the kernel uses them when it can.
+   E_HUGE_PAGES_EXPLICIT     // Reserved huge pages (MAP_HUGETLB). Falls back to transparent when none are available.
+}eHugePages;
+
+// Page mapping helpers for LargeBuffer. 'numMappedBytes' is the size of the mapping (rounded up to whole pages).
+void* largeBufferMap(size_t numBytes, eHugePages hugePages, size_t& numMappedBytes);
+void largeBufferUnmap(void* data, size_t numMappedBytes);
+size_t largeBufferPageSize(eHugePages hugePages);
+
+// Buffer for big arrays (the heat map dB values, color levels and RGB), mapped straight from the OS
+// instead of the heap so it can be backed by huge pages.
+//
+// Unlike std::vector, allocating does not initialize (or touch) the values. Each page is only
+// placed in memory when it is first written, on the NUMA node of the thread that writes it, so
+// the worker that computes a slice of the buffer gets that slice in its local memory.
+template<typename T>
+class LargeBuffer
+{
+public:
+   LargeBuffer(eHugePages hugePages = E_HUGE_PAGES_OFF): m_hugePages(hugePages){}
+   virtual ~LargeBuffer(){clear();}
+
+   void setHugePages(eHugePages hugePages){m_hugePages = hugePages;}
+
+   // Makes room for 'num' values. The old values are dropped (the mapping is reused when it is big enough).
+   void allocate(size_t num)
+   {
+      if(num*sizeof(T) > m_numMappedBytes)
+      {
+         clear();
+         m_data = (T*)largeBufferMap(num*sizeof(T), m_hugePages, m_numMappedBytes);
+         if(m_data == nullptr)
+            return;
+      }
+      m_size = num;
+   }
+
+   void clear()
+   {
+      if(m_data != nullptr)
+         largeBufferUnmap(m_data, m_numMappedBytes);
+      m_data = nullptr;
+      m_size = 0;
+      m_numMappedBytes = 0;
+   }
+
+   T* data(){return m_data;}
+   const T* data() const {return m_data;}
+   size_t size() const {return m_size;}
+   bool empty() const {return m_size == 0;}
+   T& operator[](size_t index){return m_data[index];}
+   const T& operator[](size_t index) const {return m_data[index];}
+
+   // Size of the pages backing the buffer (i.e. the granularity of NUMA placement).
+   size_t getPageSize(){return largeBufferPageSize(m_hugePages);}
+
+private:
+   // Make uncopyable
+   LargeBuffer(LargeBuffer const&);
+   void operator=(LargeBuffer const&);
+
+   eHugePages m_hugePages;
+   T* m_data = nullptr;
+   size_t m_size = 0;
+   size_t m_numMappedBytes = 0;
+};
@@ -0,0 +1,88 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "MappedFile.h"
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+   long pageSize = sysconf(_SC_PAGESIZE);
+   if(pageSize > 0)
+      m_pageSize = size_t(pageSize);
+
+   int fd = open(filePath.c_str(), O_RDONLY);
+   if(fd < 0)
+      return;
+
+   struct stat fileStat;
+   if(fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0)
+   {
+      void* data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+      if(data != MAP_FAILED)
+      {
+         m_data = (const uint8_t*)data;
+         m_size = size_t(fileStat.st_size);
+      }
+   }
+   close(fd); // The mapping stays valid after the file is closed.
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+MappedFile::~MappedFile()
+{
+   if(m_data != nullptr)
+   {
+      munmap((void*)m_data, m_size);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MappedFile::setAccessPattern(eAccessPattern pattern)
+{
+   if(m_data == nullptr)
+      return;
+
+   int advice = MADV_NORMAL;
+   switch(pattern)
+   {
+      default:
+      case E_ACCESS_NORMAL:     advice = MADV_NORMAL;     break;
+      case E_ACCESS_SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+      case E_ACCESS_RANDOM:     advice = MADV_RANDOM;     break;
+   }
+   madvise((void*)m_data, m_size, advice);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MappedFile::willNeed(size_t offset, size_t numBytes)
+{
+   if(m_data == nullptr || offset >= m_size)
+      return;
+   if(numBytes > (m_size - offset))
+      numBytes = m_size - offset;
+
+   // madvise needs a page aligned address.
+   size_t alignedOffset = offset - (offset % m_pageSize);
+   madvise((void*)(m_data + alignedOffset), numBytes + (offset - alignedOffset), MADV_WILLNEED);
+}
@@ -0,0 +1,57 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// Read only memory map of an entire file. Multiple threads can read from the mapping at the
+// same time without any locking or copying.
+class MappedFile
+{
+public:
+   typedef enum
+   {
+      E_ACCESS_NORMAL,
+      E_ACCESS_SEQUENTIAL, // Aggressive read ahead, pages can be dropped soon after they are read.
+      E_ACCESS_RANDOM      // No read ahead, use willNeed to prefetch the regions that will be read.
+   }eAccessPattern;
+
+   MappedFile(const std::string& filePath);
+   virtual ~MappedFile();
+
+   bool isValid(){return m_data != nullptr;}
+   const uint8_t* getData(){return m_data;}
+   size_t getSize(){return m_size;}
+
+   void setAccessPattern(eAccessPattern pattern);
+
+   // Start reading in a region of the file in the background.
+   void willNeed(size_t offset, size_t numBytes);
+
+private:
+   // Make uncopyable
+   MappedFile();
+   MappedFile(MappedFile const&);
+   void operator=(MappedFile const&);
+
+   const uint8_t* m_data = nullptr;
+   size_t m_size = 0;
+   size_t m_pageSize = 4096;
+};
@@ -0,0 +1,765 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <queue>
+#include "fpng.h"
+#include "PngEncoder.h"
+
+namespace
+{
+
+// Deflate length / distance code tables (RFC 1951, section 3.2.5)
+const uint16_t LENGTH_BASE[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+const uint8_t LENGTH_EXTRA[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+const uint16_t DIST_BASE[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+const uint8_t DIST_EXTRA[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+const uint8_t CODE_LENGTH_ORDER[19] = {16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
+
+const size_t NUM_LIT_LEN_CODES = 286;
+const size_t NUM_DIST_CODES = 30;
+const size_t NUM_CODE_LEN_CODES = 19;
+const size_t MIN_MATCH = 3;
+const size_t MAX_MATCH = 258;
+const size_t WINDOW_SIZE = 32768;
+const size_t MAX_TOKENS_PER_BLOCK = 65536; // Start a new block (with new Huffman tables) after this many tokens.
+
+// Maps match lengths / distances to their deflate codes.
+struct tCodeLookup
+{
+   uint8_t lengthCode[MAX_MATCH+1];
+   uint8_t distCode[WINDOW_SIZE+1];
+   tCodeLookup()
+   {
+      for(size_t code = 0; code < 29; ++code)
+         for(size_t len = LENGTH_BASE[code]; len < LENGTH_BASE[code] + (1u << LENGTH_EXTRA[code]) && len <= MAX_MATCH; ++len)
+            lengthCode[len] = uint8_t(code);
+      lengthCode[MAX_MATCH] = 28; // 258 has its own code (the code before it could also represent 258).
+      for(size_t code = 0; code < NUM_DIST_CODES; ++code)
+         for(size_t dist = DIST_BASE[code]; dist < DIST_BASE[code] + (1u << DIST_EXTRA[code]) && dist <= WINDOW_SIZE; ++dist)
+            distCode[dist] = uint8_t(code);
+   }
+};
+const tCodeLookup& getCodeLookup()
+{
+   static const tCodeLookup lookup;
+   return lookup;
+}
+
+// Writes bits LSB first, the way deflate packs them.
+class BitWriter
+{
+public:
+   BitWriter(std::vector<uint8_t>& out): m_out(out){}
+
+   void put(uint32_t bits, unsigned numBits)
+   {
+      m_bitBuf |= uint64_t(bits) << m_numBits;
+      m_numBits += numBits;
+      while(m_numBits >= 8)
+      {
+         m_out.push_back(uint8_t(m_bitBuf));
+         m_bitBuf >>= 8;
+         m_numBits -= 8;
+      }
+   }
+   void alignToByte()
+   {
+      if(m_numBits > 0)
+         put(0, 8 - m_numBits);
+   }
+
+private:
+   std::vector<uint8_t>& m_out;
+   uint64_t m_bitBuf = 0;
+   unsigned m_numBits = 0;
+};
+
+// Huffman code for one deflate alphabet. Codes are stored bit reversed so they can be written LSB first.
+struct tHuffman
+{
+   std::vector<uint8_t> lengths;
+   std::vector<uint16_t> codes;
+
+   // Builds a length limited Huffman code from the symbol frequencies.
+   void build(std::vector<uint32_t> freq, unsigned maxBits)
+   {
+      size_t numSyms = freq.size();
+      lengths.assign(numSyms, 0);
+      codes.assign(numSyms, 0);
+
+      // Deflate decoders expect at least 2 codes, so make sure there are at least 2 symbols.
+      std::vector<size_t> used;
+      for(size_t i = 0; i < numSyms; ++i)
+         if(freq[i] > 0)
+            used.push_back(i);
+      for(size_t i = 0; used.size() < 2 && i < numSyms; ++i)
+      {
+         if(freq[i] == 0)
+         {
+            freq[i] = 1;
+            used.push_back(i);
+         }
+      }
+      std::stable_sort(used.begin(), used.end(), [&](size_t a, size_t b){return freq[a] < freq[b];});
+
+      // Build the Huffman tree to get the code length of each symbol.
+      struct tNode{uint64_t freq; int parent;};
+      std::vector<tNode> nodes;
+      typedef std::pair<uint64_t, int> tQueueEntry;
+      std::priority_queue<tQueueEntry, std::vector<tQueueEntry>, std::greater<tQueueEntry>> queue;
+      for(size_t sym : used)
+      {
+         queue.push(tQueueEntry(freq[sym], int(nodes.size())));
+         nodes.push_back({freq[sym], -1});
+      }
+      while(queue.size() > 1)
+      {
+         tQueueEntry a = queue.top(); queue.pop();
+         tQueueEntry b = queue.top(); queue.pop();
+         int parent = int(nodes.size());
+         nodes.push_back({a.first + b.first, -1});
+         nodes[a.second].parent = nodes[b.second].parent = parent;
+         queue.push(tQueueEntry(a.first + b.first, parent));
+      }
+
+      // Count how many symbols have each code length.
+      std::vector<uint32_t> numCodes(33, 0);
+      for(size_t i = 0; i < used.size(); ++i)
+      {
+         unsigned depth = 0;
+         for(int node = int(i); nodes[node].parent >= 0; node = nodes[node].parent)
+            ++depth;
+         ++numCodes[std::min(depth, 32u)];
+      }
+
+      // Limit the code lengths to maxBits. Move the too long codes to maxBits, then lengthen
+      // shorter codes until the code is complete again (Kraft sum == 1).
+      for(unsigned i = maxBits + 1; i <= 32; ++i)
+      {
+         numCodes[maxBits] += numCodes[i];
+         numCodes[i] = 0;
+      }
+      uint32_t total = 0;
+      for(unsigned i = maxBits; i > 0; --i)
+         total += numCodes[i] << (maxBits - i);
+      while(total != (1u << maxBits))
+      {
+         --numCodes[maxBits];
+         for(unsigned i = maxBits - 1; i > 0; --i)
+         {
+            if(numCodes[i] > 0)
+            {
+               --numCodes[i];
+               numCodes[i + 1] += 2;
+               break;
+            }
+         }
+         --total;
+      }
+
+      // Least frequent symbols get the longest codes.
+      size_t symIndex = 0;
+      for(unsigned len = maxBits; len > 0; --len)
+         for(uint32_t i = 0; i < numCodes[len]; ++i)
+            lengths[used[symIndex++]] = uint8_t(len);
+
+      // Canonical codes.
+      uint32_t nextCode[16] = {0};
+      uint32_t code = 0;
+      numCodes[0] = 0;
+      for(unsigned len = 1; len <= maxBits; ++len)
+      {
+         code = (code + numCodes[len - 1]) << 1;
+         nextCode[len] = code;
+      }
+      for(size_t sym = 0; sym < numSyms; ++sym)
+      {
+         unsigned len = lengths[sym];
+         if(len > 0)
+         {
+            uint32_t c = nextCode[len]++;
+            uint32_t reversed = 0;
+            for(unsigned b = 0; b < len; ++b)
+               reversed |= ((c >> b) & 1) << (len - 1 - b);
+            codes[sym] = uint16_t(reversed);
+         }
+      }
+   }
+
+   void write(BitWriter& bits, size_t sym) const {bits.put(codes[sym], lengths[sym]);}
+};
+
+// Tokens are either a literal byte (upper 16 bits are 0) or a match (length << 16 | distance).
+inline uint32_t makeMatch(size_t len, size_t dist){return uint32_t((len << 16) | dist);}
+
+inline size_t matchLength(const uint8_t* data, size_t pos, size_t matchPos, size_t maxLen)
+{
+   size_t len = 0;
+   while(len < maxLen && data[pos + len] == data[matchPos + len])
+      ++len;
+   return len;
+}
+
+// Estimated code lengths (in 1/16 bits) of the deflate symbols, from how often a previous parse
+// of the same data used them. Symbols the parse didn't use get the longest code.
+struct tSymbolCosts
+{
+   uint32_t litLen[NUM_LIT_LEN_CODES];
+   uint32_t dist[NUM_DIST_CODES];
+
+   tSymbolCosts(const std::vector<uint32_t>& tokens)
+   {
+      const tCodeLookup& lookup = getCodeLookup();
+      std::vector<uint32_t> litLenFreq(NUM_LIT_LEN_CODES, 0);
+      std::vector<uint32_t> distFreq(NUM_DIST_CODES, 0);
+      for(uint32_t token : tokens)
+      {
+         uint32_t len = token >> 16;
+         if(len == 0)
+         {
+            ++litLenFreq[token];
+         }
+         else
+         {
+            ++litLenFreq[257 + lookup.lengthCode[len]];
+            ++distFreq[lookup.distCode[token & 0xFFFF]];
+         }
+      }
+      size_t numMatches = tokens.size() - std::accumulate(litLenFreq.begin(), litLenFreq.begin() + 256, size_t(0));
+      for(size_t i = 0; i < NUM_LIT_LEN_CODES; ++i)
+         litLen[i] = cost(litLenFreq[i], tokens.size());
+      for(size_t i = 0; i < NUM_DIST_CODES; ++i)
+         dist[i] = cost(distFreq[i], numMatches);
+   }
+
+   uint32_t match(size_t len, size_t distance) const
+   {
+      const tCodeLookup& lookup = getCodeLookup();
+      unsigned lenCode = lookup.lengthCode[len];
+      unsigned distCode = lookup.distCode[distance];
+      return litLen[257 + lenCode] + dist[distCode] + 16 * (LENGTH_EXTRA[lenCode] + DIST_EXTRA[distCode]);
+   }
+
+   static uint32_t cost(size_t freq, size_t total)
+   {
+      if(freq == 0)
+         return 16 * 15;
+      return uint32_t(16.0 * std::min(15.0, std::max(1.0, log2(double(total) / double(freq)))));
+   }
+};
+
+// LZ77 parse of the data that only looks for repeats at a distance of 3 (runs of the same color,
+// pixels are 3 bytes) or 1 (runs of the same byte, i.e. zeros from the Up filter).
+void findRunMatches(const uint8_t* data, size_t numBytes, std::vector<uint32_t>& tokens)
+{
+   tokens.clear();
+   size_t pos = 0;
+   while(pos < numBytes)
+   {
+      size_t maxLen = std::min(MAX_MATCH, numBytes - pos);
+      size_t bestLen = 0;
+      size_t bestDist = 0;
+      for(size_t dist : {size_t(3), size_t(1)})
+      {
+         if(pos >= dist && bestLen < maxLen)
+         {
+            size_t len = matchLength(data, pos, pos - dist, maxLen);
+            if(len > bestLen)
+            {
+               bestLen = len;
+               bestDist = dist;
+            }
+         }
+      }
+      if(bestLen >= MIN_MATCH)
+      {
+         tokens.push_back(makeMatch(bestLen, bestDist));
+         pos += bestLen;
+      }
+      else
+      {
+         tokens.push_back(data[pos++]);
+      }
+   }
+}
+
+// LZ77 parse of the data. Fast mode only looks for runs (see findRunMatches).
+//
+// The slower mode starts from that parse to estimate what each symbol will cost, then parses again
+// also searching hash chains for matches further back. Heat maps are noisy and most of the matches
+// found this way are short and far back, so a match is only taken when it is estimated to cost
+// fewer bits than the literals it replaces, and matches are compared by how many bits they save
+// rather than by length. The parse is also lazy: if the match starting at the next byte saves more,
+// the current byte is written as a literal instead.
+void findMatches(const uint8_t* data, size_t numBytes, bool fastEncode, std::vector<uint32_t>& tokens)
+{
+   findRunMatches(data, numBytes, tokens);
+   if(fastEncode)
+      return;
+
+   // Running sum of what the run parse costs up to each byte (a match's cost is spread over its
+   // bytes). What another parse saves over it between two bytes is then a subtraction.
+   const tSymbolCosts costs(tokens);
+   std::vector<uint32_t> runCostSum(numBytes + 1, 0);
+   size_t tokenPos = 0;
+   for(uint32_t token : tokens)
+   {
+      size_t len = std::max(token >> 16, 1u);
+      uint32_t cost = len == 1 ? costs.litLen[token] : costs.match(len, token & 0xFFFF);
+      for(size_t i = 1; i <= len; ++i)
+         runCostSum[tokenPos + i] = runCostSum[tokenPos] + uint32_t(cost * i / len);
+      tokenPos += len;
+   }
+   auto literalGain = [&](size_t pos){return int64_t(runCostSum[pos + 1] - runCostSum[pos]) - int64_t(costs.litLen[data[pos]]);};
+
+   // Hash chains of the positions with the same 3 bytes, newest first.
+   static const size_t HASH_BITS = 15;
+   static const size_t MAX_CHAIN = 4; // Most candidates to check per position.
+   static const size_t NICE_MATCH = 64; // Stop searching once a match is this long.
+   std::vector<int32_t> hashHead(1 << HASH_BITS, -1);
+   std::vector<int32_t> hashPrev(WINDOW_SIZE, -1);
+   auto hash = [&](size_t pos)
+   {
+      uint32_t val = uint32_t(data[pos]) | (uint32_t(data[pos + 1]) << 8) | (uint32_t(data[pos + 2]) << 16);
+      return (val * 2654435761u) >> (32 - HASH_BITS);
+   };
+   size_t numHashed = 0; // Positions before this have been added to the hash chains.
+
+   // The token at 'pos' that saves the most bits, a literal (0 length) unless a match saves more.
+   struct tMatch{size_t len; size_t dist; int64_t gain;};
+   auto findBest = [&](size_t pos)
+   {
+      tMatch best = {0, 0, literalGain(pos)};
+      size_t maxLen = std::min(MAX_MATCH, numBytes - pos);
+      if(maxLen < MIN_MATCH)
+         return best;
+      auto consider = [&](size_t dist)
+      {
+         size_t len = matchLength(data, pos, pos - dist, maxLen);
+         if(len < MIN_MATCH)
+            return;
+         int64_t gain = int64_t(runCostSum[pos + len] - runCostSum[pos]) - int64_t(costs.match(len, dist));
+         if(gain > best.gain)
+         {
+            best.len = len;
+            best.dist = dist;
+            best.gain = gain;
+         }
+      };
+      for(size_t dist : {size_t(3), size_t(1)})
+      {
+         if(pos >= dist)
+            consider(dist);
+      }
+
+      for(; numHashed < pos; ++numHashed)
+      {
+         uint32_t h = hash(numHashed);
+         hashPrev[numHashed & (WINDOW_SIZE - 1)] = hashHead[h];
+         hashHead[h] = int32_t(numHashed);
+      }
+      int32_t candidate = hashHead[hash(pos)];
+      for(size_t chain = 0; chain < MAX_CHAIN && candidate >= 0 && best.len < NICE_MATCH && best.len < maxLen; ++chain)
+      {
+         size_t dist = pos - size_t(candidate);
+         if(dist > WINDOW_SIZE)
+            break;
+         if(dist != 1 && dist != 3 && data[candidate + best.len] == data[pos + best.len])
+            consider(dist);
+         int32_t next = hashPrev[size_t(candidate) & (WINDOW_SIZE - 1)];
+         if(next >= candidate)
+            break; // The entry was overwritten by a newer position, the rest of the chain is out of the window.
+         candidate = next;
+      }
+      return best;
+   };
+
+   tokens.clear();
+   size_t pos = 0;
+   tMatch match = findBest(0);
+   while(pos < numBytes)
+   {
+      // Lazy evaluation, a literal followed by the token at the next byte might save more.
+      if(match.len > 0 && match.len < NICE_MATCH && pos + 1 < numBytes)
+      {
+         tMatch next = findBest(pos + 1);
+         if(literalGain(pos) + next.gain > match.gain)
+         {
+            tokens.push_back(data[pos++]);
+            match = next;
+            continue;
+         }
+      }
+      if(match.len > 0)
+      {
+         tokens.push_back(makeMatch(match.len, match.dist));
+         pos += match.len;
+      }
+      else
+      {
+         tokens.push_back(data[pos++]);
+      }
+      if(pos < numBytes)
+         match = findBest(pos);
+   }
+}
+
+// Writes one dynamic Huffman block.
+void writeBlock(BitWriter& bits, const uint32_t* tokens, size_t numTokens, bool finalBlock)
+{
+   const tCodeLookup& lookup = getCodeLookup();
+
+   std::vector<uint32_t> litLenFreq(NUM_LIT_LEN_CODES, 0);
+   std::vector<uint32_t> distFreq(NUM_DIST_CODES, 0);
+   for(size_t i = 0; i < numTokens; ++i)
+   {
+      uint32_t len = tokens[i] >> 16;
+      if(len == 0)
+      {
+         ++litLenFreq[tokens[i]];
+      }
+      else
+      {
+         ++litLenFreq[257 + lookup.lengthCode[len]];
+         ++distFreq[lookup.distCode[tokens[i] & 0xFFFF]];
+      }
+   }
+   litLenFreq[256] = 1; // End of block
+
+   tHuffman litLen, dist;
+   litLen.build(litLenFreq, 15);
+   dist.build(distFreq, 15);
+
+   // The code lengths of both alphabets are sent as one run length encoded list.
+   size_t numLitLen = NUM_LIT_LEN_CODES;
+   while(numLitLen > 257 && litLen.lengths[numLitLen - 1] == 0)
+      --numLitLen;
+   size_t numDist = NUM_DIST_CODES;
+   while(numDist > 1 && dist.lengths[numDist - 1] == 0)
+      --numDist;
+   std::vector<uint8_t> allLengths(litLen.lengths.begin(), litLen.lengths.begin() + numLitLen);
+   allLengths.insert(allLengths.end(), dist.lengths.begin(), dist.lengths.begin() + numDist);
+
+   std::vector<uint16_t> clSymbols; // Code length symbol | (extra bits value << 8)
+   std::vector<uint32_t> clFreq(NUM_CODE_LEN_CODES, 0);
+   for(size_t i = 0; i < allLengths.size();)
+   {
+      uint8_t len = allLengths[i];
+      size_t run = 1;
+      while(i + run < allLengths.size() && allLengths[i + run] == len)
+         ++run;
+      size_t remaining = run;
+      if(len == 0)
+      {
+         while(remaining >= 11)
+         {
+            size_t n = std::min(remaining, size_t(138));
+            clSymbols.push_back(uint16_t(18 | ((n - 11) << 8)));
+            remaining -= n;
+         }
+         if(remaining >= 3)
+         {
+            clSymbols.push_back(uint16_t(17 | ((remaining - 3) << 8)));
+            remaining = 0;
+         }
+      }
+      else
+      {
+         clSymbols.push_back(len);
+         --remaining;
+         while(remaining >= 3)
+         {
+            size_t n = std::min(remaining, size_t(6));
+            clSymbols.push_back(uint16_t(16 | ((n - 3) << 8)));
+            remaining -= n;
+         }
+      }
+      for(; remaining > 0; --remaining)
+         clSymbols.push_back(len);
+      i += run;
+   }
+   for(uint16_t sym : clSymbols)
+      ++clFreq[sym & 0xFF];
+
+   tHuffman codeLen;
+   codeLen.build(clFreq, 7);
+   size_t numCodeLen = NUM_CODE_LEN_CODES;
+   while(numCodeLen > 4 && codeLen.lengths[CODE_LENGTH_ORDER[numCodeLen - 1]] == 0)
+      --numCodeLen;
+
+   // Block header
+   bits.put(finalBlock ? 1 : 0, 1);
+   bits.put(2, 2); // Dynamic Huffman codes
+   bits.put(uint32_t(numLitLen - 257), 5);
+   bits.put(uint32_t(numDist - 1), 5);
+   bits.put(uint32_t(numCodeLen - 4), 4);
+   for(size_t i = 0; i < numCodeLen; ++i)
+      bits.put(codeLen.lengths[CODE_LENGTH_ORDER[i]], 3);
+   for(uint16_t sym : clSymbols)
+   {
+      codeLen.write(bits, sym & 0xFF);
+      switch(sym & 0xFF)
+      {
+         case 16: bits.put(sym >> 8, 2); break;
+         case 17: bits.put(sym >> 8, 3); break;
+         case 18: bits.put(sym >> 8, 7); break;
+         default: break;
+      }
+   }
+
+   // Block data
+   for(size_t i = 0; i < numTokens; ++i)
+   {
+      uint32_t len = tokens[i] >> 16;
+      if(len == 0)
+      {
+         litLen.write(bits, tokens[i]);
+      }
+      else
+      {
+         uint32_t distance = tokens[i] & 0xFFFF;
+         unsigned lenCode = lookup.lengthCode[len];
+         unsigned distCode = lookup.distCode[distance];
+         litLen.write(bits, 257 + lenCode);
+         bits.put(len - LENGTH_BASE[lenCode], LENGTH_EXTRA[lenCode]);
+         dist.write(bits, distCode);
+         bits.put(distance - DIST_BASE[distCode], DIST_EXTRA[distCode]);
+      }
+   }
+   litLen.write(bits, 256);
+}
+
+// Compresses the data as a series of deflate blocks. If this isn't the last strip of the image, an
+// empty stored block is added so the output ends on a byte boundary (the next strip can be appended).
+void deflateStrip(const uint8_t* data, size_t numBytes, bool lastStrip, bool fastEncode, std::vector<uint8_t>& out)
+{
+   std::vector<uint32_t> tokens;
+   findMatches(data, numBytes, fastEncode, tokens);
+
+   BitWriter bits(out);
+   size_t tokenIndex = 0;
+   do
+   {
+      size_t numTokens = std::min(tokens.size() - tokenIndex, MAX_TOKENS_PER_BLOCK);
+      bool finalBlock = lastStrip && (tokenIndex + numTokens) == tokens.size();
+      writeBlock(bits, tokens.data() + tokenIndex, numTokens, finalBlock);
+      tokenIndex += numTokens;
+   }while(tokenIndex < tokens.size());
+
+   if(!lastStrip)
+   {
+      bits.put(0, 3); // Stored block, not final
+      bits.alignToByte();
+      bits.put(0x0000, 16); // LEN
+      bits.put(0xFFFF, 16); // NLEN
+   }
+   bits.alignToByte();
+}
+
+// Combines the Adler-32 of two consecutive pieces of data (same math as zlib's adler32_combine).
+uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t len2)
+{
+   const uint64_t BASE = 65521;
+   uint64_t rem = len2 % BASE;
+   uint64_t sum1 = adler1 & 0xFFFF;
+   uint64_t sum2 = (rem * sum1) % BASE;
+   sum1 += (adler2 & 0xFFFF) + BASE - 1;
+   sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + BASE - rem;
+   if(sum1 >= BASE) sum1 -= BASE;
+   if(sum1 >= BASE) sum1 -= BASE;
+   if(sum2 >= (BASE << 1)) sum2 -= (BASE << 1);
+   if(sum2 >= BASE) sum2 -= BASE;
+   return uint32_t(sum1 | (sum2 << 16));
+}
+
+void putBigEndian(uint8_t* dst, uint32_t val)
+{
+   dst[0] = uint8_t(val >> 24);
+   dst[1] = uint8_t(val >> 16);
+   dst[2] = uint8_t(val >> 8);
+   dst[3] = uint8_t(val);
+}
+
+void writeChunk(std::ofstream& file, const char* type, const uint8_t* data, size_t numBytes)
+{
+   uint8_t header[8];
+   putBigEndian(header, uint32_t(numBytes));
+   memcpy(header + 4, type, 4);
+   uint32_t crc = fpng::fpng_crc32(header + 4, 4);
+   crc = fpng::fpng_crc32(data, numBytes, crc);
+   uint8_t footer[4];
+   putBigEndian(footer, crc);
+
+   file.write((const char*)header, sizeof(header));
+   file.write((const char*)data, numBytes);
+   file.write((const char*)footer, sizeof(footer));
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PngStreamWriter::PngStreamWriter(const std::string& savePath, size_t width, size_t height, bool fastEncode)
+   : m_width(width)
+   , m_height(height)
+   , m_fastEncode(fastEncode)
+   , m_prevRow(3*width, 0) // The row above the first row is all zeros.
+{
+   if(width == 0 || height == 0 || width > 0x7FFFFFFF || height > 0x7FFFFFFF)
+      return;
+
+   m_file.open(savePath.c_str(), std::ios::binary);
+   if(!m_file.is_open())
+      return;
+
+   static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+   m_file.write((const char*)PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+
+   uint8_t ihdr[13];
+   putBigEndian(ihdr, uint32_t(width));
+   putBigEndian(ihdr + 4, uint32_t(height));
+   ihdr[8] = 8;  // Bit depth
+   ihdr[9] = 2;  // Color type: RGB
+   ihdr[10] = 0; // Compression: deflate
+   ihdr[11] = 0; // Filter method
+   ihdr[12] = 0; // No interlace
+   writeChunk(m_file, "IHDR", ihdr, sizeof(ihdr));
+   m_valid = m_file.good();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PngStreamWriter::~PngStreamWriter()
+{
+   finish();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PngStreamWriter::writeRows(const uint8_t* rgb, size_t numRows, WorkerPool* workerPool)
+{
+   if(!m_valid || numRows == 0)
+      return m_valid;
+   numRows = std::min(numRows, m_height - m_rowsWritten);
+   if(numRows == 0)
+      return m_valid; // All the rows have already been written.
+
+   // Strips of about 1 MB each, but make sure all the workers get something to do.
+   const size_t rowBytes = 3*m_width;
+   size_t numThreads = workerPool != nullptr ? workerPool->getNumThreads() : 1;
+   size_t rowsPerStrip = std::max(size_t(1), (size_t(1) << 20) / rowBytes);
+   rowsPerStrip = std::min(rowsPerStrip, std::max(size_t(1), (numRows + numThreads - 1) / numThreads));
+   const size_t numStrips = (numRows + rowsPerStrip - 1) / rowsPerStrip;
+   const bool lastRows = (m_rowsWritten + numRows) == m_height;
+
+   struct tStrip
+   {
+      std::vector<uint8_t> compressed;
+      uint32_t adler;
+      size_t numBytes;
+   };
+   std::vector<tStrip> strips(numStrips);
+
+   auto compressStrips = [&](size_t workerIndex, size_t beginStrip, size_t endStrip)
+   {
+      std::vector<uint8_t> filtered;
+      for(size_t stripIndex = beginStrip; stripIndex < endStrip; ++stripIndex)
+      {
+         // Apply the 'Up' filter to the rows in this strip.
+         size_t beginRow = stripIndex*rowsPerStrip;
+         size_t endRow = std::min(beginRow + rowsPerStrip, numRows);
+         filtered.resize((endRow - beginRow)*(rowBytes + 1));
+         uint8_t* writePtr = filtered.data();
+         for(size_t row = beginRow; row < endRow; ++row)
+         {
+            const uint8_t* cur = rgb + row*rowBytes;
+            const uint8_t* prev = row == 0 ? m_prevRow.data() : cur - rowBytes;
+            *writePtr++ = 2; // 'Up' filter
+            for(size_t i = 0; i < rowBytes; ++i)
+               writePtr[i] = uint8_t(cur[i] - prev[i]);
+            writePtr += rowBytes;
+         }
+
+         tStrip& strip = strips[stripIndex];
+         if(m_rowsWritten == 0 && stripIndex == 0)
+         {
+            strip.compressed.push_back(0x78); // zlib header: deflate, 32K window
+            strip.compressed.push_back(0x01);
+         }
+         deflateStrip(filtered.data(), filtered.size(), lastRows && stripIndex == numStrips - 1, m_fastEncode, strip.compressed);
+         strip.adler = fpng::fpng_adler32(filtered.data(), filtered.size());
+         strip.numBytes = filtered.size();
+      }
+   };
+   if(workerPool != nullptr && numStrips > 1)
+      workerPool->parallelFor(numStrips, 1, compressStrips);
+   else
+      compressStrips(0, 0, numStrips);
+
+   for(const auto& strip : strips)
+   {
+      m_adler = adler32Combine(m_adler, strip.adler, strip.numBytes);
+      writeChunk(m_file, "IDAT", strip.compressed.data(), strip.compressed.size());
+   }
+   memcpy(m_prevRow.data(), rgb + (numRows-1)*rowBytes, rowBytes);
+   m_rowsWritten += numRows;
+   m_valid = m_file.good();
+   return m_valid;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PngStreamWriter::finish()
+{
+   if(!m_valid)
+      return false;
+   m_valid = false; // Nothing else can be written.
+
+   if(m_rowsWritten < m_height)
+   {
+      // Not all the rows were written. Fill the rest of the image with black.
+      m_valid = true;
+      std::vector<uint8_t> black(3*m_width, 0);
+      while(m_valid && m_rowsWritten < m_height)
+         writeRows(black.data(), 1);
+      if(!m_valid)
+         return false;
+      m_valid = false;
+   }
+
+   uint8_t adlerBytes[4];
+   putBigEndian(adlerBytes, m_adler);
+   writeChunk(m_file, "IDAT", adlerBytes, sizeof(adlerBytes));
+   writeChunk(m_file, "IEND", nullptr, 0);
+   m_file.close();
+   return !m_file.fail();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool savePngParallel(const std::string& savePath, const uint8_t* rgb, size_t width, size_t height, WorkerPool& workerPool, bool fastEncode)
+{
+   PngStreamWriter png(savePath, width, height, fastEncode);
+   png.writeRows(rgb, height, &workerPool);
+   return png.finish();
+}
@@ -0,0 +1,70 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "WorkerPool.h"
+
+// Multi-threaded PNG (8 bit RGB) encoder. The image is split into strips of rows and every strip is
+// compressed on its own, so the strips can be compressed in parallel and then simply concatenated.
+// Each strip ends with an empty stored deflate block (i.e. a zlib sync flush) so the next strip
+// starts on a byte boundary, and each strip is written out as its own IDAT chunk.
+//
+// All rows use the PNG 'Up' filter. Fast mode only looks for repeated pixels / bytes (RLE), the
+// slower mode also searches for matches further back, but only uses the ones that are estimated
+// to take fewer bits than the RLE parse.
+bool savePngParallel(const std::string& savePath, const uint8_t* rgb, size_t width, size_t height, WorkerPool& workerPool, bool fastEncode);
+
+// Writes a PNG (8 bit RGB) file a block of rows at a time, so the full image never has to be in
+// memory. Each block of rows is compressed as described above (on the worker pool, if one is
+// given) and appended to the file as IDAT chunks. Rows must be written top to bottom.
+class PngStreamWriter
+{
+public:
+   PngStreamWriter(const std::string& savePath, size_t width, size_t height, bool fastEncode);
+   virtual ~PngStreamWriter();
+
+   bool isValid(){return m_valid;}
+   size_t getNumRowsWritten(){return m_rowsWritten;}
+
+   bool writeRows(const uint8_t* rgb, size_t numRows, WorkerPool* workerPool = nullptr);
+
+   // Ends the file (called by the destructor if it hasn't been called already). If not all the rows
+   // have been written, the rest of the image is filled with black.
+   bool finish();
+
+private:
+   // Make uncopyable
+   PngStreamWriter();
+   PngStreamWriter(PngStreamWriter const&);
+   void operator=(PngStreamWriter const&);
+
+   std::ofstream m_file;
+   size_t m_width;
+   size_t m_height;
+   bool m_fastEncode;
+   bool m_valid = false;
+
+   size_t m_rowsWritten = 0;
+   std::vector<uint8_t> m_prevRow; // Needed to filter the first row of the next block.
+   uint32_t m_adler = 1; // Adler-32 of all the (filtered) rows written so far.
+};
@@ -0,0 +1,222 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <time.h>
+#include <stdio.h>
+#include <atomic>
+#include <algorithm>
+#include "Profiler.h"
+
+static const char* STAGE_NAMES[Profiler::E_NUM_STAGES] = {"readFromFile", "doFft", "fftToRgb", "encode", "lockWait"};
+static const char* QUEUE_NAMES[Profiler::E_NUM_QUEUES] = {"rowsPending", "framesQueued"};
+
+Profiler::Profiler(bool traceEvents)
+   : m_traceEvents(traceEvents)
+   , m_startTime(std::chrono::steady_clock::now())
+{
+   static std::atomic<uint64_t> nextId(1);
+   m_id = nextId++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler::~Profiler()
+{
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int64_t Profiler::wallNs()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int64_t Profiler::threadCpuNs()
+{
+   struct timespec ts;
+   if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+      return 0;
+   return int64_t(ts.tv_sec)*1000000000 + ts.tv_nsec;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler::tThreadData* Profiler::getThreadData()
+{
+   // Cache the calling thread's buffer, only a thread's first record takes the lock.
+   thread_local uint64_t cachedId = 0;
+   thread_local tThreadData* cachedData = nullptr;
+   if(cachedId != m_id)
+   {
+      std::lock_guard<std::mutex> lock(m_threadsMutex);
+      m_threads.emplace_back(new tThreadData());
+      m_threads.back()->threadIndex = m_threads.size() - 1;
+      cachedData = m_threads.back().get();
+      cachedId = m_id;
+   }
+   return cachedData;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::beginScope(Scope& scope, eStage stage, size_t numBytes, size_t numItems)
+{
+   scope.m_stage = stage;
+   scope.m_numBytes = numBytes;
+   scope.m_numItems = numItems;
+   scope.m_startCpuNs = threadCpuNs();
+   scope.m_startWallNs = wallNs();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::endScope(Scope& scope)
+{
+   int64_t endWallNs = wallNs();
+   int64_t endCpuNs = threadCpuNs();
+   tThreadData* thread = getThreadData();
+   tStageStats& stats = thread->stages[scope.m_stage];
+   ++stats.numCalls;
+   stats.wallNs += endWallNs - scope.m_startWallNs;
+   stats.cpuNs += endCpuNs - scope.m_startCpuNs;
+   stats.numBytes += scope.m_numBytes;
+   stats.numItems += scope.m_numItems;
+   if(m_traceEvents)
+      thread->traceEvents.push_back({scope.m_stage, scope.m_startWallNs, endWallNs - scope.m_startWallNs});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::queueDepth(eQueue queue, size_t depth)
+{
+   tThreadData* thread = getThreadData();
+   tQueueStats& stats = thread->queues[queue];
+   ++stats.numSamples;
+   stats.depthSum += depth;
+   stats.maxDepth = std::max(stats.maxDepth, uint64_t(depth));
+   if(m_traceEvents)
+      thread->queueEvents.push_back({queue, wallNs(), depth});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler::tStageStats Profiler::getStageTotals(eStage stage)
+{
+   std::lock_guard<std::mutex> lock(m_threadsMutex);
+   return sumStage(stage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler::tStageStats Profiler::sumStage(eStage stage)
+{
+   tStageStats total;
+   for(auto& thread : m_threads)
+   {
+      total.numCalls += thread->stages[stage].numCalls;
+      total.wallNs += thread->stages[stage].wallNs;
+      total.cpuNs += thread->stages[stage].cpuNs;
+      total.numBytes += thread->stages[stage].numBytes;
+      total.numItems += thread->stages[stage].numItems;
+   }
+   return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Profiler::saveSummary(const std::string& savePath)
+{
+   FILE* file = fopen(savePath.c_str(), "w");
+   if(file == nullptr)
+      return false;
+
+   std::lock_guard<std::mutex> lock(m_threadsMutex);
+   double totalSeconds = wallNs() * 1e-9;
+
+   // Totals across all the threads. Wall time is summed, so it can be more than the total time.
+   tStageStats stages[E_NUM_STAGES];
+   for(size_t i = 0; i < E_NUM_STAGES; ++i)
+      stages[i] = sumStage(eStage(i));
+   tQueueStats queues[E_NUM_QUEUES];
+   for(auto& thread : m_threads)
+   {
+      for(size_t i = 0; i < E_NUM_QUEUES; ++i)
+      {
+         queues[i].numSamples += thread->queues[i].numSamples;
+         queues[i].depthSum += thread->queues[i].depthSum;
+         queues[i].maxDepth = std::max(queues[i].maxDepth, thread->queues[i].maxDepth);
+      }
+   }
+
+   // Throughput is per second of total time, i.e. what the whole run achieved.
+   fprintf(file, "{\n   \"totalSeconds\": %.6f,\n   \"numThreads\": %zu,\n   \"stages\": {\n", totalSeconds, m_threads.size());
+   for(size_t i = 0; i < E_NUM_STAGES; ++i)
+   {
+      const tStageStats& stats = stages[i];
+      fprintf(file, "      \"%s\": {\"calls\": %llu, \"wallSeconds\": %.6f, \"cpuSeconds\": %.6f, \"bytes\": %llu, \"items\": %llu, \"bytesPerSecond\": %.1f, \"itemsPerSecond\": %.1f}%s\n",
+         STAGE_NAMES[i], (unsigned long long)stats.numCalls, stats.wallNs * 1e-9, stats.cpuNs * 1e-9,
+         (unsigned long long)stats.numBytes, (unsigned long long)stats.numItems,
+         totalSeconds > 0 ? stats.numBytes / totalSeconds : 0.0, totalSeconds > 0 ? stats.numItems / totalSeconds : 0.0,
+         i + 1 < E_NUM_STAGES ? "," : "");
+   }
+   fprintf(file, "   },\n   \"queues\": {\n");
+   for(size_t i = 0; i < E_NUM_QUEUES; ++i)
+   {
+      const tQueueStats& stats = queues[i];
+      fprintf(file, "      \"%s\": {\"samples\": %llu, \"meanDepth\": %.2f, \"maxDepth\": %llu}%s\n",
+         QUEUE_NAMES[i], (unsigned long long)stats.numSamples, stats.numSamples > 0 ? double(stats.depthSum) / stats.numSamples : 0.0,
+         (unsigned long long)stats.maxDepth, i + 1 < E_NUM_QUEUES ? "," : "");
+   }
+   fprintf(file, "   }\n}\n");
+   return fclose(file) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Profiler::saveTrace(const std::string& savePath)
+{
+   FILE* file = fopen(savePath.c_str(), "w");
+   if(file == nullptr)
+      return false;
+
+   // Chrome trace event format, times are in microseconds.
+   std::lock_guard<std::mutex> lock(m_threadsMutex);
+   const char* separator = "";
+   fprintf(file, "{\"traceEvents\": [\n");
+   for(auto& thread : m_threads)
+   {
+      fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %zu, \"args\": {\"name\": \"thread %zu\"}}",
+         separator, thread->threadIndex, thread->threadIndex);
+      separator = ",\n";
+      for(auto& event : thread->traceEvents)
+      {
+         fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %zu, \"ts\": %.3f, \"dur\": %.3f}",
+            STAGE_NAMES[event.stage], thread->threadIndex, event.startNs * 1e-3, event.durationNs * 1e-3);
+      }
+      for(auto& event : thread->queueEvents)
+      {
+         fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 1, \"ts\": %.3f, \"args\": {\"depth\": %zu}}",
+            QUEUE_NAMES[event.queue], event.timeNs * 1e-3, event.depth);
+      }
+   }
+   fprintf(file, "\n]}\n");
+   return fclose(file) == 0;
+}
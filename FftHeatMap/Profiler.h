@@ -0,0 +1,155 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+// Collects per stage wall / CPU time and throughput counters from any number of threads, and can
+// save them as a JSON summary and as a Chrome trace event file (chrome://tracing or Perfetto).
+//
+// Each thread records into its own buffer, so recording never takes a lock (only the first
+// record on a new thread does). Code that is instrumented holds a Profiler pointer that is null
+// when profiling is off, so the only cost left in the processing is a null check per scope.
+class Profiler
+{
+public:
+   typedef enum
+   {
+      E_STAGE_READ,      // Reading samples from the input.
+      E_STAGE_FFT,       // Window, FFT and power to dB / color levels.
+      E_STAGE_RENDER,    // Color levels to RGB.
+      E_STAGE_ENCODE,    // Image compression / writing.
+      E_STAGE_LOCK_WAIT, // Waiting on the shared input stream lock.
+      E_NUM_STAGES
+   }eStage;
+
+   typedef enum
+   {
+      E_QUEUE_ROWS,   // Heat map rows not yet claimed by a worker.
+      E_QUEUE_FRAMES, // Stream frames waiting to be processed.
+      E_NUM_QUEUES
+   }eQueue;
+
+   typedef struct tStageStats
+   {
+      uint64_t numCalls = 0;
+      int64_t wallNs = 0;
+      int64_t cpuNs = 0;
+      uint64_t numBytes = 0;
+      uint64_t numItems = 0;
+   }tStageStats;
+
+   // 'traceEvents' keeps every scope (for saveTrace), otherwise only the totals are kept.
+   Profiler(bool traceEvents);
+   virtual ~Profiler();
+
+   // Times the life of the scope as 'stage' on the calling thread. 'numBytes' / 'numItems' are
+   // added to the stage's throughput counters. Does nothing when 'profiler' is null.
+   class Scope
+   {
+   public:
+      Scope(Profiler* profiler, eStage stage, size_t numBytes = 0, size_t numItems = 0): m_profiler(profiler)
+      {
+         if(m_profiler != nullptr)
+            m_profiler->beginScope(*this, stage, numBytes, numItems);
+      }
+      ~Scope()
+      {
+         if(m_profiler != nullptr)
+            m_profiler->endScope(*this);
+      }
+
+   private:
+      friend class Profiler;
+      Scope(Scope const&);
+      void operator=(Scope const&);
+
+      Profiler* m_profiler;
+      eStage m_stage;
+      size_t m_numBytes;
+      size_t m_numItems;
+      int64_t m_startWallNs;
+      int64_t m_startCpuNs;
+   };
+
+   // Records the current depth of a queue.
+   void queueDepth(eQueue queue, size_t depth);
+
+   // Totals of a stage across all the threads. Wall time is summed, so it can be more than the total time.
+   tStageStats getStageTotals(eStage stage);
+
+   bool saveSummary(const std::string& savePath);
+   bool saveTrace(const std::string& savePath);
+
+private:
+   // Make uncopyable
+   Profiler();
+   Profiler(Profiler const&);
+   void operator=(Profiler const&);
+
+   typedef struct tQueueStats
+   {
+      uint64_t numSamples = 0;
+      uint64_t depthSum = 0;
+      uint64_t maxDepth = 0;
+   }tQueueStats;
+
+   typedef struct tTraceEvent
+   {
+      eStage stage;
+      int64_t startNs; // Relative to the profiler's creation.
+      int64_t durationNs;
+   }tTraceEvent;
+
+   typedef struct tQueueEvent
+   {
+      eQueue queue;
+      int64_t timeNs;
+      size_t depth;
+   }tQueueEvent;
+
+   typedef struct tThreadData
+   {
+      size_t threadIndex;
+      tStageStats stages[E_NUM_STAGES];
+      tQueueStats queues[E_NUM_QUEUES];
+      std::vector<tTraceEvent> traceEvents;
+      std::vector<tQueueEvent> queueEvents;
+   }tThreadData;
+
+   void beginScope(Scope& scope, eStage stage, size_t numBytes, size_t numItems);
+   void endScope(Scope& scope);
+   tThreadData* getThreadData();
+   tStageStats sumStage(eStage stage); // m_threadsMutex must be held.
+   int64_t wallNs();
+   static int64_t threadCpuNs();
+
+   uint64_t m_id; // Unique per profiler, so a thread's cached buffer pointer is never used with the wrong profiler.
+   bool m_traceEvents;
+   std::chrono::steady_clock::time_point m_startTime;
+
+   std::mutex m_threadsMutex;
+   std::vector<std::unique_ptr<tThreadData>> m_threads;
+};
@@ -0,0 +1,157 @@
+/* Copyright 2024, 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <math.h>
+#include <limits>
+#include <type_traits>
+#include <algorithm>
+#include "SignalGen.h"
+
+static std::default_random_engine g_generator;
+
+void makeComplexSineWave(double sampRate, double waveFreq, size_t numSamp, dubVect& re, dubVect& im)
+{
+   re.resize(numSamp);
+   im.resize(numSamp);
+   double phaseIncr = 2.0 * M_PI * waveFreq / sampRate;
+   double phase = 0;
+   for(size_t i = 0; i < numSamp; ++i)
+   {
+      re[i] = cos(phase);
+      im[i] = sin(phase);
+      phase += phaseIncr;
+   }
+}
+
+void addRandom(dubVect& re, dubVect& im, double randVal)
+{
+   std::uniform_real_distribution<double> distribution(-randVal, randVal);
+   size_t numSamp = std::min(re.size(), im.size());
+   for(size_t i = 0; i < numSamp; ++i)
+   {
+      re[i] += distribution(g_generator);
+      im[i] += distribution(g_generator);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SignalGen::SignalGen(double sampRate, uint32_t seed)
+   : m_sampRate(sampRate)
+   , m_generator(seed)
+{
+}
+
+void SignalGen::addTone(double freq, double amplitude)
+{
+   m_signals.push_back({E_TONE, freq, freq, amplitude, 0, 0, 0});
+}
+
+void SignalGen::addChirp(double startFreq, double stopFreq, double sweepSeconds, double amplitude)
+{
+   m_signals.push_back({E_CHIRP, startFreq, stopFreq, amplitude, sweepSeconds, sweepSeconds, 0});
+}
+
+void SignalGen::addBurst(double freq, double amplitude, double onSeconds, double periodSeconds)
+{
+   m_signals.push_back({E_BURST, freq, freq, amplitude, onSeconds, periodSeconds, 0});
+}
+
+void SignalGen::setNoise(double amplitude)
+{
+   m_noiseAmplitude = amplitude;
+}
+
+void SignalGen::generate(double* iq, size_t numSamp)
+{
+   std::fill(iq, iq + 2*numSamp, 0.0);
+
+   for(auto& signal : m_signals)
+   {
+      // The phase is accumulated (rather than computed from the time) so chirps stay continuous.
+      double phaseIncr = 2.0 * M_PI * signal.freq / m_sampRate;
+      uint64_t periodSamps = std::max(uint64_t(1), uint64_t(signal.periodSeconds * m_sampRate + 0.5));
+      uint64_t onSamps = uint64_t(signal.onSeconds * m_sampRate + 0.5);
+      double chirpRate = signal.type == E_CHIRP ? 2.0 * M_PI * (signal.stopFreq - signal.freq) / (m_sampRate * double(periodSamps)) : 0;
+      for(size_t i = 0; i < numSamp; ++i)
+      {
+         uint64_t periodIndex = signal.type == E_TONE ? 0 : (m_sampleIndex + i) % periodSamps;
+         if(signal.type == E_CHIRP)
+            phaseIncr = 2.0 * M_PI * signal.freq / m_sampRate + chirpRate * double(periodIndex);
+         if(signal.type != E_BURST || periodIndex < onSamps)
+         {
+            iq[2*i+0] += signal.amplitude * cos(signal.phase);
+            iq[2*i+1] += signal.amplitude * sin(signal.phase);
+         }
+         signal.phase += phaseIncr;
+         if(signal.phase > M_PI)
+            signal.phase -= 2.0 * M_PI;
+         else if(signal.phase < -M_PI)
+            signal.phase += 2.0 * M_PI;
+      }
+   }
+
+   if(m_noiseAmplitude > 0)
+   {
+      std::uniform_real_distribution<double> distribution(-m_noiseAmplitude, m_noiseAmplitude);
+      for(size_t i = 0; i < 2*numSamp; ++i)
+         iq[i] += distribution(m_generator);
+   }
+   m_sampleIndex += numSamp;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType>
+void convertFromDouble(const double* iq, tSampType* out, size_t numValues)
+{
+   if(std::is_floating_point<tSampType>())
+   {
+      for(size_t i = 0; i < numValues; ++i)
+         out[i] = tSampType(iq[i]);
+      return;
+   }
+
+   // Full scale maps to the max value. Unsigned types are offset by half their range.
+   const double maxVal = double(std::numeric_limits<tSampType>::max());
+   const double scale = std::is_signed<tSampType>() ? maxVal : maxVal / 2.0;
+   const double offset = std::is_signed<tSampType>() ? 0.0 : maxVal / 2.0;
+   const double minVal = double(std::numeric_limits<tSampType>::min());
+   for(size_t i = 0; i < numValues; ++i)
+   {
+      double val = round(iq[i] * scale + offset);
+      // Clip, keeping in mind doubles can't represent the 64 bit limits exactly.
+      if(val >= maxVal)
+         out[i] = std::numeric_limits<tSampType>::max();
+      else if(val <= minVal)
+         out[i] = std::numeric_limits<tSampType>::min();
+      else
+         out[i] = tSampType(val);
+   }
+}
+
+template void convertFromDouble<int8_t>(const double*, int8_t*, size_t);
+template void convertFromDouble<int16_t>(const double*, int16_t*, size_t);
+template void convertFromDouble<int32_t>(const double*, int32_t*, size_t);
+template void convertFromDouble<int64_t>(const double*, int64_t*, size_t);
+template void convertFromDouble<uint8_t>(const double*, uint8_t*, size_t);
+template void convertFromDouble<uint16_t>(const double*, uint16_t*, size_t);
+template void convertFromDouble<uint32_t>(const double*, uint32_t*, size_t);
+template void convertFromDouble<uint64_t>(const double*, uint64_t*, size_t);
+template void convertFromDouble<float>(const double*, float*, size_t);
+template void convertFromDouble<double>(const double*, double*, size_t);
@@ -0,0 +1,77 @@
+/* Copyright 2024, 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <random>
+#include "fftHelper.h"
+
+// Simple test signals.
+void makeComplexSineWave(double sampRate, double waveFreq, size_t numSamp, dubVect& re, dubVect& im);
+void addRandom(dubVect& re, dubVect& im, double randVal = 0.08);
+
+// Synthetic IQ capture generator. The signal is made of any number of tones, chirps and bursts plus
+// white noise. Samples are generated a block at a time (each block continues where the last one
+// left off), so captures of any size can be generated with a fixed amount of memory.
+class SignalGen
+{
+public:
+   SignalGen(double sampRate, uint32_t seed = 1);
+
+   // Amplitudes are relative to full scale (1.0). Frequencies are in Hz (-sampRate/2 to sampRate/2).
+   void addTone(double freq, double amplitude);
+   void addChirp(double startFreq, double stopFreq, double sweepSeconds, double amplitude); // Repeats every sweepSeconds.
+   void addBurst(double freq, double amplitude, double onSeconds, double periodSeconds); // On for onSeconds at the start of every period.
+   void setNoise(double amplitude); // Uniform noise on I and Q.
+
+   // Generates the next 'numSamp' interleaved IQ samples.
+   void generate(double* iq, size_t numSamp);
+
+private:
+   typedef enum
+   {
+      E_TONE,
+      E_CHIRP,
+      E_BURST
+   }eSignalType;
+
+   typedef struct tSignal
+   {
+      eSignalType type;
+      double freq;
+      double stopFreq;
+      double amplitude;
+      double onSeconds;
+      double periodSeconds;
+      double phase;
+   }tSignal;
+
+   double m_sampRate;
+   std::vector<tSignal> m_signals;
+   double m_noiseAmplitude = 0;
+   uint64_t m_sampleIndex = 0;
+   std::default_random_engine m_generator;
+};
+
+// Converts interleaved IQ samples (full scale is 1.0) to tSampType. Integer types are scaled to their
+// full range (unsigned types are offset binary) and clipped, floating point types are copied as is.
+template<typename tSampType>
+void convertFromDouble(const double* iq, tSampType* out, size_t numValues);
@@ -0,0 +1,459 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include "fftHelper.h"
+#include "fftKernels.h"
+#include "hsvrgb.h"
+#include "WorkerPool.h"
+#include "PngEncoder.h"
+#include "Profiler.h"
+
+typedef struct tStreamToHeatMapConfig
+{
+   std::string inputPath = ""; // Named pipe (or file) to read from. Empty or "-" means stdin.
+   double sampleRate = 1.0;
+   size_t fftSize = 1024;
+   double timeBetweenFfts = 1.0;
+   size_t numThreads = 1;
+   double maxLevelDb = std::numeric_limits<double>::infinity(); // init to invalid value
+   double rangeDb = 100.0;
+   size_t fftBatchSize = 0; // Number of FFTs to run per FFTW call. 0 means pick based on the FFT size.
+   bool fastPngEncode = false; // Faster PNG compression at the cost of bigger files.
+   size_t numRows = 1024; // Number of rows (most recent FFTs) in the waterfall image.
+   double refreshSeconds = 1.0; // How often the waterfall image is rewritten.
+   double maxLatencySeconds = 1.0; // How many seconds of FFTs can be queued up waiting to be processed.
+   std::shared_ptr<Profiler> profiler; // Per stage timing / trace events (see Profiler.h). Null means off.
+   WorkerPool::eAffinity workerAffinity = WorkerPool::E_AFFINITY_NONE;
+} tStreamToHeatMapConfig;
+
+// Generates a rolling waterfall from IQ samples as they arrive on stdin or a named pipe (i.e. input
+// that can't be seeked or sized up front). A reader thread cuts the samples into FFT frames and puts
+// them in a fixed size queue, the worker pool turns batches of queued frames into rows of color
+// levels in a ring buffer of the most recent rows, and the waterfall image (newest row on top) is
+// rewritten every refresh period.
+//
+// Memory is bounded: when the FFTs fall behind the input rate the queue fills up and new frames are
+// dropped (and reported) instead of queued, so a sample is never more than the queue length plus a
+// refresh period away from its pixel.
+template<typename tSampType, typename tFftType = double>
+class StreamToHeatMap
+{
+public:
+   // Public Constants
+   static constexpr size_t COMPLEX_SAMP_SIZE = 2*sizeof(tSampType);
+
+public:
+   StreamToHeatMap(const tStreamToHeatMapConfig& config);
+   virtual ~StreamToHeatMap();
+
+   // Processes the input until it ends, rewriting 'savePath' (PNG) every refresh period. Each image
+   // is written to a temporary file first and then renamed, so readers never see a partial image.
+   void run(const std::string& savePath);
+
+   size_t getNumFfts(){return m_numFftsDone;}
+   size_t getNumDropped(){return m_numDropped;}
+
+private:
+   // Make uncopyable
+   StreamToHeatMap();
+   StreamToHeatMap(StreamToHeatMap const&);
+   void operator=(StreamToHeatMap const&);
+
+   void readerThread();
+   void queueFrame(const uint8_t* frame);
+   void processFrames(size_t firstFrame, size_t numFrames);
+   void doFft(size_t workerIndex, size_t firstFrame, size_t numFrames);
+   void saveWaterfall(const std::string& savePath);
+   void reportDrops();
+
+   /////////////////////////////////////////////////////////////////////////////
+   // Member Variables
+   /////////////////////////////////////////////////////////////////////////////
+
+   // Settings
+   int m_inputFd = -1;
+   bool m_closeInput = false;
+   size_t m_fftSize = 1;
+   size_t m_sampBetweenFfts = 1;
+   size_t m_fftBatchSize = 1;
+   size_t m_numRows = 1;
+   double m_refreshSeconds = 1.0;
+   bool m_fastPngEncode = false;
+   double m_fftToRgb_max_dB = 0; // Any dB value above this will be the max RGB value.
+   double m_fftToRgb_range_dB = 100;
+
+   // FFT Window (interleaved, i.e. each coefficient is repeated for I and Q)
+   std::vector<tFftType> m_fftWindow;
+   bool m_fftShiftByModulation = false; // True if the window centers DC, i.e. the FFT output doesn't need to be swapped.
+
+   // Queue of FFT frames waiting to be processed. Frame 'n' is stored in slot n % m_maxQueuedFrames.
+   // The reader thread owns the slots from m_framesQueued on, the processing owns the slots from
+   // m_framesDone up to m_framesQueued.
+   std::vector<tSampType> m_frames;
+   size_t m_maxQueuedFrames = 1;
+   size_t m_framesQueued = 0;
+   size_t m_framesDone = 0;
+   bool m_inputDone = false;
+   std::mutex m_queueMutex;
+   std::condition_variable m_queueCondVar;
+
+   // Ring buffer of the most recent rows (color levels). Row 'n' is stored in slot n % m_numRows.
+   std::vector<uint8_t> m_rowLevel;
+   size_t m_numFftsDone = 0;
+   std::vector<uint8_t> m_rgb;
+
+   // Drops
+   size_t m_numDropped = 0; // Protected by m_queueMutex.
+   size_t m_numDroppedReported = 0;
+
+   // Threading
+   std::unique_ptr<WorkerPool> m_workerPool;
+   std::vector<std::vector<tFftType>> m_fft_dB; // One per worker thread.
+   std::thread m_readerThread;
+
+   // Instrumentation (null when off)
+   std::shared_ptr<Profiler> m_profiler;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+
+template<typename tSampType, typename tFftType>
+StreamToHeatMap<tSampType, tFftType>::StreamToHeatMap(const tStreamToHeatMapConfig& config)
+   : m_fftSize(std::max(size_t(1), config.fftSize))
+   , m_refreshSeconds(config.refreshSeconds)
+   , m_fastPngEncode(config.fastPngEncode)
+   , m_profiler(config.profiler)
+{
+   if(config.inputPath == "" || config.inputPath == "-")
+   {
+      m_inputFd = STDIN_FILENO;
+   }
+   else
+   {
+      m_inputFd = open(config.inputPath.c_str(), O_RDONLY);
+      m_closeInput = m_inputFd >= 0;
+   }
+
+   m_sampBetweenFfts = std::max(size_t(1), size_t(config.sampleRate * config.timeBetweenFfts + 0.5));
+   m_numRows = std::max(size_t(1), config.numRows);
+
+   // Same scaling as FileToHeatMap (there is no normalize option, the scale must be known up front).
+   if(std::isfinite(config.maxLevelDb))
+      m_fftToRgb_max_dB = config.maxLevelDb;
+   else if(std::is_floating_point<tSampType>())
+      m_fftToRgb_max_dB = 0;
+   else
+      m_fftToRgb_max_dB = 20.0 * log10(double(std::numeric_limits<tSampType>::max()));
+   m_fftToRgb_range_dB = config.rangeDb;
+   if(!std::isfinite(m_fftToRgb_range_dB) || m_fftToRgb_range_dB <= 0 || m_fftToRgb_range_dB > 1000)
+      m_fftToRgb_range_dB = 100;
+
+   // Generate Window Coefs (with the FFT normalization and, for even FFT sizes, the DC shift folded in)
+   dubVect fftWindow(m_fftSize);
+   m_fftShiftByModulation = genFftShiftWindowCoef(fftWindow.data(), m_fftSize);
+   m_fftWindow.resize(2*m_fftSize);
+   for(size_t i = 0; i < m_fftSize; ++i)
+   {
+      m_fftWindow[2*i+0] = m_fftWindow[2*i+1] = tFftType(fftWindow[i]);
+   }
+
+   m_fftBatchSize = config.fftBatchSize;
+   if(m_fftBatchSize == 0)
+      m_fftBatchSize = std::max(size_t(1), std::min(size_t(64), size_t(16384) / m_fftSize));
+
+   size_t numThreads = std::max(size_t(1), config.numThreads);
+   m_workerPool.reset(new WorkerPool(numThreads, config.workerAffinity));
+   m_fft_dB.resize(numThreads, std::vector<tFftType>(m_fftSize));
+
+   // The queue holds 'maxLatencySeconds' worth of FFTs, but always at least a few full rounds of
+   // batches so the workers don't starve.
+   double fftsPerSecond = config.sampleRate / double(m_sampBetweenFfts);
+   double maxQueued = std::isfinite(fftsPerSecond) ? fftsPerSecond * config.maxLatencySeconds : 0;
+   m_maxQueuedFrames = std::max(size_t(maxQueued > 0 ? maxQueued : 0), 4*numThreads*m_fftBatchSize);
+   m_frames.resize(2*m_fftSize*m_maxQueuedFrames);
+   m_rowLevel.resize(m_numRows*m_fftSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+StreamToHeatMap<tSampType, tFftType>::~StreamToHeatMap()
+{
+   if(m_readerThread.joinable())
+      m_readerThread.join();
+   if(m_closeInput)
+      close(m_inputFd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void StreamToHeatMap<tSampType, tFftType>::run(const std::string& savePath)
+{
+   if(m_inputFd < 0)
+   {
+      fprintf(stderr, "Failed to open the input\n");
+      return;
+   }
+
+   fpng::fpng_init();
+   m_readerThread = std::thread(&StreamToHeatMap::readerThread, this);
+
+   // A pass never has more frames than the waterfall has rows, otherwise 2 frames of the same pass
+   // would map to the same row (and race to write it).
+   const size_t maxFramesPerPass = std::max(size_t(1), std::min(m_workerPool->getNumThreads()*m_fftBatchSize, m_numRows));
+   auto refreshPeriod = std::chrono::duration<double>(m_refreshSeconds);
+   auto nextRefresh = std::chrono::steady_clock::now() + refreshPeriod;
+   size_t numFftsSaved = 0;
+   while(1)
+   {
+      // Wait for frames to process (or for the next refresh).
+      size_t firstFrame, numFrames;
+      bool inputDone;
+      {
+         std::unique_lock<std::mutex> lock(m_queueMutex);
+         m_queueCondVar.wait_until(lock, nextRefresh, [this]{return m_framesQueued > m_framesDone || m_inputDone;});
+         firstFrame = m_framesDone;
+         numFrames = std::min(m_framesQueued - m_framesDone, maxFramesPerPass);
+         inputDone = m_inputDone && numFrames == 0;
+         if(m_profiler != nullptr)
+            m_profiler->queueDepth(Profiler::E_QUEUE_FRAMES, m_framesQueued - m_framesDone);
+      }
+
+      if(numFrames > 0)
+      {
+         processFrames(firstFrame, numFrames);
+         std::lock_guard<std::mutex> lock(m_queueMutex);
+         m_framesDone += numFrames; // Hand the slots back to the reader.
+      }
+      m_queueCondVar.notify_all();
+
+      // Rewrite the waterfall and report any new drops every refresh period (and once more at the end).
+      auto now = std::chrono::steady_clock::now();
+      if(now >= nextRefresh || inputDone)
+      {
+         if(m_numFftsDone > numFftsSaved)
+         {
+            saveWaterfall(savePath);
+            numFftsSaved = m_numFftsDone;
+         }
+         reportDrops();
+         nextRefresh = now + refreshPeriod;
+      }
+
+      if(inputDone)
+         break;
+   }
+   m_readerThread.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void StreamToHeatMap<tSampType, tFftType>::readerThread()
+{
+   // Samples that have been read but not yet consumed by an FFT frame. 'pendingStart' is the index
+   // (in samples since the start of the stream) of the first pending sample.
+   static constexpr size_t READ_SIZE = 1 << 16;
+   std::vector<uint8_t> pending;
+   size_t pendingStart = 0;
+   size_t nextFftStart = 0;
+   while(1)
+   {
+      size_t numPending = pending.size();
+      pending.resize(numPending + READ_SIZE);
+      ssize_t numRead = read(m_inputFd, pending.data() + numPending, READ_SIZE);
+      if(numRead < 0 && errno == EINTR)
+         numRead = 0;
+      else if(numRead <= 0)
+         break; // End of the stream (or an error).
+      pending.resize(numPending + numRead);
+
+      // Cut out all the complete frames.
+      size_t numPendingSamples = pending.size() / COMPLEX_SAMP_SIZE;
+      while(nextFftStart + m_fftSize <= pendingStart + numPendingSamples)
+      {
+         queueFrame(pending.data() + COMPLEX_SAMP_SIZE*(nextFftStart - pendingStart));
+         nextFftStart += m_sampBetweenFfts;
+      }
+
+      // Drop the samples no future frame needs (i.e. keep the partial frame, if any).
+      size_t numDrop = std::min(nextFftStart - pendingStart, numPendingSamples);
+      pending.erase(pending.begin(), pending.begin() + COMPLEX_SAMP_SIZE*numDrop);
+      pendingStart += numDrop;
+   }
+
+   std::lock_guard<std::mutex> lock(m_queueMutex);
+   m_inputDone = true;
+   m_queueCondVar.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void StreamToHeatMap<tSampType, tFftType>::queueFrame(const uint8_t* frame)
+{
+   size_t frameIndex;
+   {
+      std::lock_guard<std::mutex> lock(m_queueMutex);
+      if(m_framesQueued - m_framesDone >= m_maxQueuedFrames)
+      {
+         ++m_numDropped; // Queue is full, don't wait (that would just back up the input).
+         return;
+      }
+      frameIndex = m_framesQueued;
+   }
+
+   // The slot belongs to the reader until the frame is queued, copy without holding the lock.
+   tSampType* slot = &m_frames[2*m_fftSize*(frameIndex % m_maxQueuedFrames)];
+   memcpy(slot, frame, COMPLEX_SAMP_SIZE*m_fftSize);
+
+   std::lock_guard<std::mutex> lock(m_queueMutex);
+   ++m_framesQueued;
+   m_queueCondVar.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void StreamToHeatMap<tSampType, tFftType>::processFrames(size_t firstFrame, size_t numFrames)
+{
+   m_workerPool->parallelFor(numFrames, m_fftBatchSize, [&](size_t workerIndex, size_t beginIndex, size_t endIndex)
+   {
+      doFft(workerIndex, firstFrame + beginIndex, endIndex - beginIndex);
+   });
+   m_numFftsDone += numFrames;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void StreamToHeatMap<tSampType, tFftType>::reportDrops()
+{
+   size_t numDropped;
+   {
+      std::lock_guard<std::mutex> lock(m_queueMutex);
+      numDropped = m_numDropped;
+   }
+   if(numDropped > m_numDroppedReported)
+   {
+      fprintf(stderr, "Dropped %zu FFTs (%zu total), processing can't keep up with the input rate\n", numDropped - m_numDroppedReported, numDropped);
+      m_numDroppedReported = numDropped;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void StreamToHeatMap<tSampType, tFftType>::doFft(size_t workerIndex, size_t firstFrame, size_t numFrames)
+{
+   Profiler::Scope fftScope(m_profiler.get(), Profiler::E_STAGE_FFT, COMPLEX_SAMP_SIZE*m_fftSize*numFrames, numFrames);
+
+   // A short pass (fewer frames than a full batch) runs one frame at a time on the single FFT plan,
+   // so the number of frames in a pass never creates a new plan.
+   const size_t framesPerExecute = numFrames == m_fftBatchSize ? m_fftBatchSize : 1;
+   ComplexFftBatch<tFftType>& fftBatch = ComplexFftBatch<tFftType>::get(m_fftSize, framesPerExecute);
+   const tFftType* window = m_fftWindow.data();
+
+   // Dropped frames never make it into the queue, so queued frame 'n' is row 'n' of the waterfall.
+   const size_t numEndFftPointsToSwap = m_fftShiftByModulation ? 0 : m_fftSize >> 1; // round down
+   const size_t numBeginFftPointsToSwap = m_fftSize - numEndFftPointsToSwap;
+   const double MIN_DB_FS_VAL = m_fftToRgb_max_dB - m_fftToRgb_range_dB;
+   const double DELTA_DB_FS_VAL = m_fftToRgb_max_dB - MIN_DB_FS_VAL;
+   tFftType* fftDbPtr = m_fft_dB[workerIndex].data();
+   tFftType fftMax = -std::numeric_limits<tFftType>::infinity();
+   tFftType fftMin = std::numeric_limits<tFftType>::infinity();
+   for(size_t executeStart = 0; executeStart < numFrames; executeStart += framesPerExecute)
+   {
+      for(size_t i = 0; i < framesPerExecute; ++i)
+      {
+         const tSampType* iqSamples = &m_frames[2*m_fftSize*((firstFrame + executeStart + i) % m_maxQueuedFrames)];
+         tFftType* fftIn = fftBatch.getInput(i);
+         convertAndWindow(iqSamples, window, fftIn, 2*m_fftSize);
+         if(std::is_floating_point<tSampType>())
+            fixStartNanComplex(fftIn, m_fftSize);
+      }
+      fftBatch.execute();
+
+      for(size_t i = 0; i < framesPerExecute; ++i)
+      {
+         const tFftType* fftOut = fftBatch.getOutput(i);
+         size_t row = (firstFrame + executeStart + i) % m_numRows;
+         if(numEndFftPointsToSwap > 0)
+            powerToDb(fftOut + 2*numBeginFftPointsToSwap, fftDbPtr, numEndFftPointsToSwap, tFftType(0), fftMin, fftMax);
+         powerToDb(fftOut, fftDbPtr + numEndFftPointsToSwap, numBeginFftPointsToSwap, tFftType(0), fftMin, fftMax);
+         dbToLevel(fftDbPtr, &m_rowLevel[row*m_fftSize], m_fftSize, MIN_DB_FS_VAL, DELTA_DB_FS_VAL);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void StreamToHeatMap<tSampType, tFftType>::saveWaterfall(const std::string& savePath)
+{
+   extern RgbColor LevelToRgbLookup[256];
+
+   // Newest row on top, down to the oldest row still in the ring buffer.
+   size_t numRows = std::min(m_numFftsDone, m_numRows);
+   size_t newestRow = m_numFftsDone - 1;
+   m_rgb.resize(3*numRows*m_fftSize);
+   m_workerPool->parallelFor(numRows, 64, [&](size_t workerIndex, size_t beginRow, size_t endRow)
+   {
+      Profiler::Scope renderScope(m_profiler.get(), Profiler::E_STAGE_RENDER, 3*(endRow - beginRow)*m_fftSize, (endRow - beginRow)*m_fftSize);
+      for(size_t outRow = beginRow; outRow < endRow; ++outRow)
+      {
+         const uint8_t* levelPtr = &m_rowLevel[((newestRow - outRow) % m_numRows)*m_fftSize];
+         uint8_t* rgbPtr = &m_rgb[3*outRow*m_fftSize];
+         for(size_t bin = 0; bin < m_fftSize; ++bin, rgbPtr += 3)
+         {
+            rgbPtr[0] = LevelToRgbLookup[levelPtr[bin]].r;
+            rgbPtr[1] = LevelToRgbLookup[levelPtr[bin]].g;
+            rgbPtr[2] = LevelToRgbLookup[levelPtr[bin]].b;
+         }
+      }
+   });
+
+   std::string tempPath = savePath + ".tmp";
+   Profiler::Scope encodeScope(m_profiler.get(), Profiler::E_STAGE_ENCODE, m_rgb.size(), 1);
+   if(savePngParallel(tempPath, m_rgb.data(), m_fftSize, numRows, *m_workerPool, m_fastPngEncode))
+      rename(tempPath.c_str(), savePath.c_str());
+}
@@ -0,0 +1,216 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include "WorkerPool.h"
+
+// Parses a Linux CPU list, e.g. "0-3,8-11".
+static std::vector<size_t> ParseCpuList(const std::string& cpuList)
+{
+   std::vector<size_t> cpus;
+   const char* str = cpuList.c_str();
+   char* end = nullptr;
+   while(*str != '\0')
+   {
+      size_t first = strtoul(str, &end, 10);
+      if(end == str)
+         break;
+      size_t last = first;
+      if(*end == '-')
+      {
+         str = end + 1;
+         last = strtoul(str, &end, 10);
+      }
+      for(size_t cpu = first; cpu <= last; ++cpu)
+         cpus.push_back(cpu);
+      str = (*end == ',') ? end + 1 : end;
+   }
+   return cpus;
+}
+
+// The CPUs of each NUMA node that this process is allowed to run on. A machine (or kernel)
+// without NUMA is a single node with all the allowed CPUs.
+static std::vector<std::vector<size_t>> GetNodeCpus(const std::vector<size_t>& allowedCpus)
+{
+   std::vector<std::vector<size_t>> nodeCpus;
+   for(size_t node = 0; ; ++node)
+   {
+      std::ifstream cpuListFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      std::string cpuList;
+      if(!std::getline(cpuListFile, cpuList))
+         break;
+      std::vector<size_t> cpus;
+      for(auto cpu : ParseCpuList(cpuList))
+      {
+         if(std::find(allowedCpus.begin(), allowedCpus.end(), cpu) != allowedCpus.end())
+            cpus.push_back(cpu);
+      }
+      if(!cpus.empty())
+         nodeCpus.push_back(cpus);
+   }
+   if(nodeCpus.empty())
+      nodeCpus.push_back(allowedCpus);
+   return nodeCpus;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+WorkerPool::WorkerPool(size_t numThreads, eAffinity affinity)
+{
+   m_threads.reserve(numThreads);
+   for(size_t i = 0; i < numThreads; ++i)
+   {
+      m_threads.emplace_back(&WorkerPool::workerThread, this, i);
+   }
+   if(affinity != E_AFFINITY_NONE)
+      setAffinity(affinity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+WorkerPool::~WorkerPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_exit = true;
+   }
+   m_startCondVar.notify_all();
+   for(auto& thread : m_threads)
+   {
+      thread.join();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::setAffinity(eAffinity affinity)
+{
+   cpu_set_t allowedSet;
+   CPU_ZERO(&allowedSet);
+   if(sched_getaffinity(0, sizeof(allowedSet), &allowedSet) != 0)
+      return;
+   std::vector<size_t> allowedCpus;
+   for(size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+   {
+      if(CPU_ISSET(cpu, &allowedSet))
+         allowedCpus.push_back(cpu);
+   }
+   if(allowedCpus.empty())
+      return;
+
+   // The workers are idle until the first job, so they are pinned before they touch any memory.
+   std::vector<std::vector<size_t>> nodeCpus = GetNodeCpus(allowedCpus);
+   for(size_t i = 0; i < m_threads.size(); ++i)
+   {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      if(affinity == E_AFFINITY_CORE)
+      {
+         CPU_SET(allowedCpus[i % allowedCpus.size()], &cpuSet);
+      }
+      else
+      {
+         for(auto cpu : nodeCpus[i % nodeCpus.size()])
+            CPU_SET(cpu, &cpuSet);
+      }
+      pthread_setaffinity_np(m_threads[i].native_handle(), sizeof(cpuSet), &cpuSet);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::runOnAllWorkers(const tWorkerFunc& func)
+{
+   if(m_threads.empty())
+   {
+      func(0); // Inline pool, run on the calling thread.
+      return;
+   }
+
+   std::lock_guard<std::mutex> runLock(m_runMutex);
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_func = &func;
+   m_numWorkersBusy = m_threads.size();
+   ++m_jobCount;
+   m_startCondVar.notify_all();
+
+   // Wait until all the workers have finished the job.
+   while(m_numWorkersBusy > 0)
+   {
+      m_doneCondVar.wait(lock);
+   }
+   m_func = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::parallelFor(size_t numItems, size_t chunkSize, const tRangeFunc& func)
+{
+   if(numItems == 0)
+      return;
+   if(chunkSize == 0)
+      chunkSize = 1;
+
+   std::atomic<size_t> nextIndex(0);
+   runOnAllWorkers([&](size_t workerIndex)
+   {
+      size_t beginIndex;
+      while((beginIndex = nextIndex.fetch_add(chunkSize, std::memory_order_relaxed)) < numItems)
+      {
+         size_t endIndex = std::min(beginIndex + chunkSize, numItems);
+         func(workerIndex, beginIndex, endIndex);
+      }
+   });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::workerThread(size_t workerIndex)
+{
+   uint64_t lastJobCount = 0;
+   std::unique_lock<std::mutex> lock(m_mutex);
+   while(1)
+   {
+      // Wait for a new job (or for the pool to be destroyed).
+      while(!m_exit && m_jobCount == lastJobCount)
+      {
+         m_startCondVar.wait(lock);
+      }
+      if(m_exit)
+         break;
+      lastJobCount = m_jobCount;
+      const tWorkerFunc* func = m_func;
+
+      // Run the job without holding the lock.
+      lock.unlock();
+      (*func)(workerIndex);
+      lock.lock();
+
+      // Wake up the caller once the last worker has finished.
+      if(--m_numWorkersBusy == 0)
+      {
+         m_doneCondVar.notify_one();
+      }
+   }
+}
@@ -0,0 +1,80 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Long lived pool of worker threads. The threads are created once and then reused for every job
+// that is run on the pool. A job is run on all the workers at once and the caller blocks until
+// every worker has finished the job.
+//
+// A pool made with 0 threads runs every job on the calling thread (as worker 0). That lets code
+// written against a pool run inline, e.g. when it is already running on a worker of another pool.
+class WorkerPool
+{
+public:
+   typedef std::function<void(size_t workerIndex)> tWorkerFunc;
+   typedef std::function<void(size_t workerIndex, size_t beginIndex, size_t endIndex)> tRangeFunc;
+
+   typedef enum
+   {
+      E_AFFINITY_NONE, // Let the OS schedule the workers.
+      E_AFFINITY_CORE, // Pin each worker to a single core (round robin over the cores this process is allowed to use).
+      E_AFFINITY_NODE  // Pin each worker to the cores of a NUMA node (workers are spread round robin over the nodes).
+   }eAffinity;
+
+   WorkerPool(size_t numThreads, eAffinity affinity = E_AFFINITY_NONE);
+   virtual ~WorkerPool();
+
+   size_t getNumThreads(){return m_threads.empty() ? 1 : m_threads.size();}
+
+   // Runs 'func' once on every worker thread. Returns after all the workers are done.
+   void runOnAllWorkers(const tWorkerFunc& func);
+
+   // Splits [0, numItems) into chunks of 'chunkSize' items. The workers claim chunks from a lock
+   // free counter until there are no chunks left. Returns after all the chunks have been processed.
+   void parallelFor(size_t numItems, size_t chunkSize, const tRangeFunc& func);
+
+private:
+   // Make uncopyable
+   WorkerPool();
+   WorkerPool(WorkerPool const&);
+   void operator=(WorkerPool const&);
+
+   void workerThread(size_t workerIndex);
+   void setAffinity(eAffinity affinity);
+
+   std::vector<std::thread> m_threads;
+
+   std::mutex m_runMutex; // Only one job can run on the pool at a time.
+   std::mutex m_mutex;
+   std::condition_variable m_startCondVar;
+   std::condition_variable m_doneCondVar;
+
+   const tWorkerFunc* m_func = nullptr;
+   uint64_t m_jobCount = 0;
+   size_t m_numWorkersBusy = 0;
+   bool m_exit = false;
+};
@@ -18,12 +18,120 @@
  */
 #include <fftw3.h>
 #include <math.h>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "fftHelper.h"
 
+// The FFTW planner is not thread safe. Everything other than fftw_execute needs to hold this lock.
+static std::mutex g_fftwPlannerMutex;
+static unsigned g_fftwPlanFlags = FFTW_ESTIMATE;
+
+// Maps the FFTW API onto the FFT sample type (double uses fftw_*, float uses fftwf_*).
+template<typename tFftType> struct FftwApi;
+template<> struct FftwApi<double>
+{
+   typedef fftw_complex tComplex;
+   typedef fftw_plan tPlan;
+   static void* malloc(size_t n){return fftw_malloc(n);}
+   static void free(void* p){fftw_free(p);}
+   static tPlan planMany(int n, int howMany, tComplex* in, tComplex* out, unsigned flags)
+      {return fftw_plan_many_dft(1, &n, howMany, in, NULL, 1, n, out, NULL, 1, n, FFTW_FORWARD, flags);}
+   static void execute(tPlan p, tComplex* in, tComplex* out){fftw_execute_dft(p, in, out);}
+   static void destroy(tPlan p){fftw_destroy_plan(p);}
+};
+template<> struct FftwApi<float>
+{
+   typedef fftwf_complex tComplex;
+   typedef fftwf_plan tPlan;
+   static void* malloc(size_t n){return fftwf_malloc(n);}
+   static void free(void* p){fftwf_free(p);}
+   static tPlan planMany(int n, int howMany, tComplex* in, tComplex* out, unsigned flags)
+      {return fftwf_plan_many_dft(1, &n, howMany, in, NULL, 1, n, out, NULL, 1, n, FFTW_FORWARD, flags);}
+   static void execute(tPlan p, tComplex* in, tComplex* out){fftwf_execute_dft(p, in, out);}
+   static void destroy(tPlan p){fftwf_destroy_plan(p);}
+};
+
+template<typename tFftType>
+ComplexFftBatch<tFftType>::ComplexFftBatch(unsigned int fftSize, unsigned int numFfts)
+   : m_fftSize(fftSize)
+   , m_numFfts(numFfts)
+{
+   typedef FftwApi<tFftType> api;
+   m_in = (tFftType*) api::malloc(sizeof(typename api::tComplex) * fftSize * numFfts);
+   m_out = (tFftType*) api::malloc(sizeof(typename api::tComplex) * fftSize * numFfts);
+
+   std::lock_guard<std::mutex> lock(g_fftwPlannerMutex);
+   m_plan = api::planMany((int)fftSize, (int)numFfts, (typename api::tComplex*)m_in, (typename api::tComplex*)m_out, g_fftwPlanFlags);
+}
+
+template<typename tFftType>
+ComplexFftBatch<tFftType>::~ComplexFftBatch()
+{
+   typedef FftwApi<tFftType> api;
+   std::lock_guard<std::mutex> lock(g_fftwPlannerMutex);
+   api::destroy((typename api::tPlan)m_plan);
+   api::free(m_in);
+   api::free(m_out);
+}
+
+template<typename tFftType>
+void ComplexFftBatch<tFftType>::execute()
+{
+   typedef FftwApi<tFftType> api;
+   api::execute((typename api::tPlan)m_plan, (typename api::tComplex*)m_in, (typename api::tComplex*)m_out);
+}
+
+template<typename tFftType>
+ComplexFftBatch<tFftType>& ComplexFftBatch<tFftType>::get(unsigned int fftSize, unsigned int numFfts)
+{
+   thread_local std::map<std::pair<unsigned int, unsigned int>, std::unique_ptr<ComplexFftBatch>> planCache;
+   auto& plan = planCache[std::make_pair(fftSize, numFfts)];
+   if(plan == nullptr)
+   {
+      plan.reset(new ComplexFftBatch(fftSize, numFfts));
+   }
+   return *plan;
+}
+
+template class ComplexFftBatch<double>;
+template class ComplexFftBatch<float>;
+
+void setFftPlanEffort(eFftPlanEffort effort)
+{
+   std::lock_guard<std::mutex> lock(g_fftwPlannerMutex);
+   switch(effort)
+   {
+      default:
+      case E_FFT_PLAN_ESTIMATE: g_fftwPlanFlags = FFTW_ESTIMATE; break;
+      case E_FFT_PLAN_MEASURE:  g_fftwPlanFlags = FFTW_MEASURE;  break;
+      case E_FFT_PLAN_PATIENT:  g_fftwPlanFlags = FFTW_PATIENT;  break;
+   }
+}
+
+// Single precision wisdom is kept in a separate file with an 'f' appended to the path
+// (same convention as FFTW's system wisdom files, i.e. /etc/fftw/wisdom and /etc/fftw/wisdomf)
+bool loadFftWisdom(const std::string& wisdomPath)
+{
+   std::lock_guard<std::mutex> lock(g_fftwPlannerMutex);
+   bool loadedDouble = fftw_import_wisdom_from_filename(wisdomPath.c_str()) != 0;
+   bool loadedFloat = fftwf_import_wisdom_from_filename((wisdomPath + "f").c_str()) != 0;
+   return loadedDouble || loadedFloat;
+}
+
+bool saveFftWisdom(const std::string& wisdomPath)
+{
+   std::lock_guard<std::mutex> lock(g_fftwPlannerMutex);
+   bool savedDouble = fftw_export_wisdom_to_filename(wisdomPath.c_str()) != 0;
+   bool savedFloat = fftwf_export_wisdom_to_filename((wisdomPath + "f").c_str()) != 0;
+   return savedDouble && savedFloat;
+}
+
 // Overwrite NaN samples at the beginning with 0's
 // There are many reasons why samples at the beginning might be NaN values:
 // Scroll mode, FM Demod, etc...
-static void fixStartNanComplex(fftw_complex* in, unsigned int N)
+template<typename tComplex>
+static void fixStartNanComplex(tComplex* in, unsigned int N)
 {
    for(unsigned int i = 0; i < N; ++i)
    {
@@ -69,68 +177,61 @@ static void fixStartNanReal(fftw_complex* in, unsigned int N)
    }
 }
 
-void complexFFT(std::mutex& fftwMutex, const dubVect& inRe, const dubVect& inIm, dubVect& outRe, dubVect& outIm, double *windowCoef)
+void fixStartNanComplex(double* interleavedIq, unsigned int N)
+{
+   fixStartNanComplex((fftw_complex*)interleavedIq, N);
+}
+
+void fixStartNanComplex(float* interleavedIq, unsigned int N)
 {
-   fftw_complex *in, *out;
-   fftw_plan p;
+   fixStartNanComplex((fftwf_complex*)interleavedIq, N);
+}
 
+void complexFFT(const dubVect& inRe, const dubVect& inIm, dubVect& outRe, dubVect& outIm, double *windowCoef)
+{
    unsigned int N = std::min(inRe.size(), inIm.size());
 
    if(N > 0)
    {
-       in = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N);
-       out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N);
-
-       if(windowCoef == NULL)
+       ComplexFftBatch<double>& plan = ComplexFftBatch<double>::get(N);
+       fftw_complex* in = (fftw_complex*)plan.getInput();
+       const fftw_complex* out = (const fftw_complex*)plan.getOutput();
+
+       // Fold the 1/N normalization into the input. For even N also multiply by (-1)^n, which puts
+       // DC in the center of the FFT output (no need to swap the halves of the output afterwards).
+       bool shiftByModulation = (N & 1) == 0;
+       double scale = 1.0 / (double)N;
+       for(unsigned int i = 0; i < N; ++i)
        {
-          for(unsigned int i = 0; i < N; ++i)
-          {
-             in[i][0] = inRe[i];
-             in[i][1] = inIm[i];
-          }
-       }
-       else
-       {
-          for(unsigned int i = 0; i < N; ++i)
-          {
-             in[i][0] = inRe[i] * windowCoef[i];
-             in[i][1] = inIm[i] * windowCoef[i];
-          }
+          double coef = windowCoef == NULL ? scale : windowCoef[i] * scale;
+          if(shiftByModulation && (i & 1))
+             coef = -coef;
+          in[i][0] = inRe[i] * coef;
+          in[i][1] = inIm[i] * coef;
        }
 
        // Overwrite NaN samples at the beginning with 0's
        fixStartNanComplex(in, N);
 
-       std::unique_lock<std::mutex> lock(fftwMutex);
-       p = fftw_plan_dft_1d(N, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-       lock.unlock();
-
-       fftw_execute(p);
-
-       lock.lock();
-       fftw_destroy_plan(p);
-       lock.unlock();
+       plan.execute();
 
        outRe.resize(N);
        outIm.resize(N);
 
-       // Swap FFT result to put DC in the center.
-       unsigned int numEndFftPointsToSwap = N >> 1; // round down
+       // Swap FFT result to put DC in the center (only needed if it wasn't done by modulation).
+       unsigned int numEndFftPointsToSwap = shiftByModulation ? 0 : N >> 1; // round down
        unsigned int numBeginFftPointsToSwap = N - numEndFftPointsToSwap;
 
        for(unsigned int i = 0; i < numEndFftPointsToSwap; ++i)
        {
-          outRe[i] = out[i+numBeginFftPointsToSwap][0] / (double)N;
-          outIm[i] = out[i+numBeginFftPointsToSwap][1] / (double)N;
+          outRe[i] = out[i+numBeginFftPointsToSwap][0];
+          outIm[i] = out[i+numBeginFftPointsToSwap][1];
        }
        for(unsigned int i = numEndFftPointsToSwap; i < N; ++i)
        {
-          outRe[i] = out[i-numEndFftPointsToSwap][0] / (double)N;
-          outIm[i] = out[i-numEndFftPointsToSwap][1] / (double)N;
+          outRe[i] = out[i-numEndFftPointsToSwap][0];
+          outIm[i] = out[i-numEndFftPointsToSwap][1];
        }
-
-       fftw_free(in);
-       fftw_free(out);
     }
    else
    {
@@ -141,17 +242,15 @@ void complexFFT(std::mutex& fftwMutex, const dubVect& inRe, const dubVect& inIm,
 
 void realFFT(const dubVect& inRe, dubVect& outRe, double* windowCoef)
 {
-   fftw_complex *in, *out;
-   fftw_plan p;
-
    unsigned int N = inRe.size();
 
    if(N > 0)
    {
        unsigned int halfN = N >> 1;
 
-       in = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N);
-       out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N);
+       ComplexFftBatch<double>& plan = ComplexFftBatch<double>::get(N);
+       fftw_complex* in = (fftw_complex*)plan.getInput();
+       const fftw_complex* out = (const fftw_complex*)plan.getOutput();
 
        if(windowCoef == NULL)
        {
@@ -173,11 +272,7 @@ void realFFT(const dubVect& inRe, dubVect& outRe, double* windowCoef)
        // Overwrite NaN samples at the beginning with 0's
        fixStartNanReal(in, N);
 
-       p = fftw_plan_dft_1d(N, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-
-       fftw_execute(p);
-
-       fftw_destroy_plan(p);
+       plan.execute();
 
        outRe.resize(halfN);
        outRe[0] = fabs(out[0][0] / (double)N);
@@ -185,9 +280,6 @@ void realFFT(const dubVect& inRe, dubVect& outRe, double* windowCoef)
        {
           outRe[i] = (fabs(out[i][0]) + fabs(out[N-i][0])) / (double)N;
        }
-
-       fftw_free(in);
-       fftw_free(out);
    }
    else
    {
@@ -312,3 +404,16 @@ void genWindowCoef(double* outSamp, unsigned int numSamp, bool scale)
       }
    }
 }
+
+bool genFftShiftWindowCoef(double* outSamp, unsigned int numSamp)
+{
+   genWindowCoef(outSamp, numSamp, true);
+
+   bool shiftByModulation = (numSamp & 1) == 0;
+   double scale = 1.0 / (double)numSamp;
+   for(unsigned int i = 0; i < numSamp; ++i)
+   {
+      outSamp[i] *= (shiftByModulation && (i & 1)) ? -scale : scale;
+   }
+   return shiftByModulation;
+}
@@ -18,10 +18,60 @@
  */
 #ifndef fftHelper_h
 #define fftHelper_h
-#include <mutex>
+#include <string>
 #include "helperTypes.h"
 
-void complexFFT(std::mutex& fftwMutex, const dubVect& inRe, const dubVect& inIm, dubVect& outRe, dubVect& outIm, double* windowCoef = NULL);
+// How much time FFTW should spend searching for the fastest plan. Anything other than
+// ESTIMATE actually runs FFTs while planning, so it is only worth it if the plans are
+// reused many times or the results are saved off as wisdom.
+typedef enum
+{
+   E_FFT_PLAN_ESTIMATE,
+   E_FFT_PLAN_MEASURE,
+   E_FFT_PLAN_PATIENT
+}eFftPlanEffort;
+
+void setFftPlanEffort(eFftPlanEffort effort);
+bool loadFftWisdom(const std::string& wisdomPath);
+bool saveFftWisdom(const std::string& wisdomPath);
+
+// Runs 'numFfts' complex FFTs of 'fftSize' points with a single FFTW plan execution.
+// The input / output buffers are aligned, interleaved (re, im) and hold the FFTs back to back.
+// Plans are created the first time a thread uses a (fftSize, numFfts) pair and then cached
+// (per thread) for all future calls, so only the first call takes the planner lock.
+// tFftType can be double (fftw) or float (fftwf).
+template<typename tFftType>
+class ComplexFftBatch
+{
+public:
+   static ComplexFftBatch& get(unsigned int fftSize, unsigned int numFfts = 1);
+   ~ComplexFftBatch();
+
+   tFftType* getInput(unsigned int fftIndex = 0){return m_in + 2*m_fftSize*fftIndex;}
+   const tFftType* getOutput(unsigned int fftIndex = 0){return m_out + 2*m_fftSize*fftIndex;}
+   unsigned int getNumFfts(){return m_numFfts;}
+   void execute();
+
+private:
+   ComplexFftBatch(unsigned int fftSize, unsigned int numFfts);
+
+   // Make uncopyable
+   ComplexFftBatch();
+   ComplexFftBatch(ComplexFftBatch const&);
+   void operator=(ComplexFftBatch const&);
+
+   unsigned int m_fftSize;
+   unsigned int m_numFfts;
+   tFftType* m_in;
+   tFftType* m_out;
+   void* m_plan;
+};
+
+// Overwrite NaN samples at the beginning with 0's
+void fixStartNanComplex(double* interleavedIq, unsigned int N);
+void fixStartNanComplex(float* interleavedIq, unsigned int N);
+
+void complexFFT(const dubVect& inRe, const dubVect& inIm, dubVect& outRe, dubVect& outIm, double* windowCoef = NULL);
 
 void realFFT(const dubVect& inRe, dubVect& outRe, double* windowCoef = NULL);
 
@@ -29,4 +79,10 @@ void getFFTXAxisValues_real(dubVect& xAxis, unsigned int numPoints, double& min,
 void getFFTXAxisValues_complex(dubVect& xAxis, unsigned int numPoints, double& min, double& max, double sampleRate = 0.0);
 
 void genWindowCoef(double* outSamp, unsigned int numSamp, bool scale);
+
+// Generates window coefficients that can be multiplied straight into the FFT input. The window scale
+// factor and the 1/N FFT normalization are folded into the coefficients. For even N every other
+// coefficient is also negated; multiplying by (-1)^n shifts the spectrum by N/2 bins, so the FFT
+// output comes out with DC already in the center. Returns true if the shift was folded in.
+bool genFftShiftWindowCoef(double* outSamp, unsigned int numSamp);
 #endif
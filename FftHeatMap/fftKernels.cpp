@@ -0,0 +1,578 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include "fftKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FFT_KERNELS_X86
+#include <immintrin.h>
+// Functions with this attribute are compiled for AVX2 regardless of the compiler flags. They must only
+// be called after checking that the CPU supports AVX2.
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+
+#ifdef FFT_KERNELS_X86
+static bool cpuHasAvx2()
+{
+   static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+   return hasAvx2;
+}
+#endif
+
+// log2(1+t) ~= t*(C0 + C1*t + C2*t^2 + C3*t^3 + C4*t^4) for t in [0, 1). Max error is 1.5e-5.
+static constexpr double LOG2_C0 =  1.4419656174876816;
+static constexpr double LOG2_C1 = -0.70966282891874;
+static constexpr double LOG2_C2 =  0.41759580405380675;
+static constexpr double LOG2_C3 = -0.1962696591243035;
+static constexpr double LOG2_C4 =  0.04638536870538555;
+static constexpr double DB_PER_LOG2 = 3.0102999566398119521; // 10*log10(2)
+
+// Bit layout of the floating point types.
+template<typename tFftType> struct FloatBits;
+template<> struct FloatBits<double>
+{
+   typedef uint64_t tUint;
+   static constexpr int MANT_BITS = 52;
+   static constexpr tUint EXP_MASK = 0x7FF;
+   static constexpr int EXP_BIAS = 1023;
+   static constexpr tUint MANT_MASK = 0x000FFFFFFFFFFFFFull;
+   static constexpr tUint ONE_BITS = 0x3FF0000000000000ull; // 1.0
+};
+template<> struct FloatBits<float>
+{
+   typedef uint32_t tUint;
+   static constexpr int MANT_BITS = 23;
+   static constexpr tUint EXP_MASK = 0xFF;
+   static constexpr int EXP_BIAS = 127;
+   static constexpr tUint MANT_MASK = 0x007FFFFF;
+   static constexpr tUint ONE_BITS = 0x3F800000; // 1.0
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Plain C++ versions (used for the samples left over after the SIMD loops and
+// when there isn't a SIMD version for a type / CPU).
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+static void convertAndWindowScalar(const tSampType* iqSamples, const tFftType* window, tFftType* fftIn, size_t numValues)
+{
+   for(size_t i = 0; i < numValues; ++i)
+   {
+      fftIn[i] = tFftType(iqSamples[i]) * window[i];
+   }
+}
+
+// log2(x) = exponent + log2(mantissa), where the mantissa is in [1, 2). NaN and inf are passed
+// through and 0 gives -inf, like std::log2.
+template<typename tFftType>
+static inline tFftType fastLog2(tFftType x)
+{
+   typedef FloatBits<tFftType> fb;
+   typename fb::tUint bits;
+   memcpy(&bits, &x, sizeof(bits));
+   typename fb::tUint expField = (bits >> fb::MANT_BITS) & fb::EXP_MASK;
+   if(expField == fb::EXP_MASK)
+      return x; // NaN or inf
+   if(x == tFftType(0))
+      return -std::numeric_limits<tFftType>::infinity();
+   tFftType exponent = tFftType(int(expField) - fb::EXP_BIAS);
+   bits = (bits & fb::MANT_MASK) | fb::ONE_BITS;
+   tFftType t;
+   memcpy(&t, &bits, sizeof(t));
+   t -= tFftType(1);
+   tFftType poly = tFftType(LOG2_C4);
+   poly = poly * t + tFftType(LOG2_C3);
+   poly = poly * t + tFftType(LOG2_C2);
+   poly = poly * t + tFftType(LOG2_C1);
+   poly = poly * t + tFftType(LOG2_C0);
+   return exponent + t * poly;
+}
+
+template<typename tFftType>
+static void powerToDbScalar(const tFftType* fftOut, tFftType* dB, size_t numBins, tFftType dBOffset, tFftType& minDb, tFftType& maxDb)
+{
+   tFftType minVal = minDb;
+   tFftType maxVal = maxDb;
+   for(size_t i = 0; i < numBins; ++i)
+   {
+      tFftType re = fftOut[2*i+0];
+      tFftType im = fftOut[2*i+1];
+      tFftType val = fastLog2(re * re + im * im) * tFftType(DB_PER_LOG2) + dBOffset;
+      dB[i] = val;
+      minVal = std::min(minVal, val);
+      maxVal = std::max(maxVal, val);
+   }
+   minDb = minVal;
+   maxDb = maxVal;
+}
+
+template<typename tFftType>
+static void combinePowerScalar(const tFftType* fftOut, tFftType* power, size_t numBins, ePowerCombine combine, bool first)
+{
+   for(size_t i = 0; i < numBins; ++i)
+   {
+      tFftType re = fftOut[2*i+0];
+      tFftType im = fftOut[2*i+1];
+      tFftType val = re * re + im * im;
+      if(first)
+         power[i] = val;
+      else if(combine == E_COMBINE_MEAN)
+         power[i] += val;
+      else if(combine == E_COMBINE_MAX)
+         power[i] = std::max(power[i], val);
+      else
+         power[i] = std::min(power[i], val);
+   }
+}
+
+template<typename tFftType>
+static void linearToDbScalar(const tFftType* power, tFftType* dB, size_t num, tFftType dBOffset, tFftType& minDb, tFftType& maxDb)
+{
+   tFftType minVal = minDb;
+   tFftType maxVal = maxDb;
+   for(size_t i = 0; i < num; ++i)
+   {
+      tFftType val = fastLog2(power[i]) * tFftType(DB_PER_LOG2) + dBOffset;
+      dB[i] = val;
+      minVal = std::min(minVal, val);
+      maxVal = std::max(maxVal, val);
+   }
+   minDb = minVal;
+   maxDb = maxVal;
+}
+
+#ifdef FFT_KERNELS_X86
+////////////////////////////////////////////////////////////////////////////////
+// AVX2 Sample Loaders. Each loads 8 samples as floats or 4 samples as doubles.
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType> struct Avx2Load
+{
+   static constexpr bool valid = false; // No SIMD conversion for this type (64 bit ints, uint32)
+};
+
+template<> struct Avx2Load<int8_t>
+{
+   static constexpr bool valid = true;
+   AVX2_FUNC static __m256 load8(const int8_t* p){return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)p)));}
+   AVX2_FUNC static __m256d load4(const int8_t* p){int32_t v; memcpy(&v, p, sizeof(v)); return _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(v)));}
+};
+
+template<> struct Avx2Load<uint8_t>
+{
+   static constexpr bool valid = true;
+   AVX2_FUNC static __m256 load8(const uint8_t* p){return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p)));}
+   AVX2_FUNC static __m256d load4(const uint8_t* p){int32_t v; memcpy(&v, p, sizeof(v)); return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));}
+};
+
+template<> struct Avx2Load<int16_t>
+{
+   static constexpr bool valid = true;
+   AVX2_FUNC static __m256 load8(const int16_t* p){return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p)));}
+   AVX2_FUNC static __m256d load4(const int16_t* p){return _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)p)));}
+};
+
+template<> struct Avx2Load<uint16_t>
+{
+   static constexpr bool valid = true;
+   AVX2_FUNC static __m256 load8(const uint16_t* p){return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p)));}
+   AVX2_FUNC static __m256d load4(const uint16_t* p){return _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)p)));}
+};
+
+template<> struct Avx2Load<int32_t>
+{
+   static constexpr bool valid = true;
+   AVX2_FUNC static __m256 load8(const int32_t* p){return _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)p));}
+   AVX2_FUNC static __m256d load4(const int32_t* p){return _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)p));}
+};
+
+template<> struct Avx2Load<float>
+{
+   static constexpr bool valid = true;
+   AVX2_FUNC static __m256 load8(const float* p){return _mm256_loadu_ps(p);}
+   AVX2_FUNC static __m256d load4(const float* p){return _mm256_cvtps_pd(_mm_loadu_ps(p));}
+};
+
+template<> struct Avx2Load<double>
+{
+   static constexpr bool valid = true;
+   AVX2_FUNC static __m256 load8(const double* p){return _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(p+4)), _mm256_cvtpd_ps(_mm256_loadu_pd(p)));}
+   AVX2_FUNC static __m256d load4(const double* p){return _mm256_loadu_pd(p);}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// AVX2 Kernels
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType>
+AVX2_FUNC static size_t convertAndWindowAvx2(const tSampType* iqSamples, const float* window, float* fftIn, size_t numValues)
+{
+   size_t i = 0;
+   for(; i + 8 <= numValues; i += 8)
+   {
+      _mm256_storeu_ps(fftIn+i, _mm256_mul_ps(Avx2Load<tSampType>::load8(iqSamples+i), _mm256_loadu_ps(window+i)));
+   }
+   return i;
+}
+
+template<typename tSampType>
+AVX2_FUNC static size_t convertAndWindowAvx2(const tSampType* iqSamples, const double* window, double* fftIn, size_t numValues)
+{
+   size_t i = 0;
+   for(; i + 4 <= numValues; i += 4)
+   {
+      _mm256_storeu_pd(fftIn+i, _mm256_mul_pd(Avx2Load<tSampType>::load4(iqSamples+i), _mm256_loadu_pd(window+i)));
+   }
+   return i;
+}
+
+AVX2_FUNC static inline __m256d fastLog2Avx2(__m256d x)
+{
+   typedef FloatBits<double> fb;
+   const __m256d TWO_52 = _mm256_set1_pd(4503599627370496.0);
+   __m256i bits = _mm256_castpd_si256(x);
+
+   // There is no int64 -> double conversion in AVX2. The exponent is small, so put it in the
+   // mantissa of 2^52 and subtract off 2^52 (and the bias).
+   __m256i expBits = _mm256_or_si256(_mm256_srli_epi64(bits, fb::MANT_BITS), _mm256_castpd_si256(TWO_52));
+   __m256d exponent = _mm256_sub_pd(_mm256_castsi256_pd(expBits), _mm256_add_pd(TWO_52, _mm256_set1_pd(fb::EXP_BIAS)));
+
+   __m256i mantBits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(fb::MANT_MASK)), _mm256_set1_epi64x(fb::ONE_BITS));
+   __m256d t = _mm256_sub_pd(_mm256_castsi256_pd(mantBits), _mm256_set1_pd(1.0));
+
+   __m256d poly = _mm256_set1_pd(LOG2_C4);
+   poly = _mm256_add_pd(_mm256_mul_pd(poly, t), _mm256_set1_pd(LOG2_C3));
+   poly = _mm256_add_pd(_mm256_mul_pd(poly, t), _mm256_set1_pd(LOG2_C2));
+   poly = _mm256_add_pd(_mm256_mul_pd(poly, t), _mm256_set1_pd(LOG2_C1));
+   poly = _mm256_add_pd(_mm256_mul_pd(poly, t), _mm256_set1_pd(LOG2_C0));
+   __m256d result = _mm256_add_pd(exponent, _mm256_mul_pd(t, poly));
+
+   // Pass NaN / inf through (exponent field all ones) and make 0 -inf.
+   const __m256i expFieldMask = _mm256_set1_epi64x((long long)(fb::EXP_MASK << fb::MANT_BITS));
+   __m256d notFinite = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(bits, expFieldMask), expFieldMask));
+   __m256d isZero = _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_EQ_OQ);
+   result = _mm256_blendv_pd(result, x, notFinite);
+   return _mm256_blendv_pd(result, _mm256_set1_pd(-std::numeric_limits<double>::infinity()), isZero);
+}
+
+AVX2_FUNC static inline __m256 fastLog2Avx2(__m256 x)
+{
+   typedef FloatBits<float> fb;
+   __m256i bits = _mm256_castps_si256(x);
+   __m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, fb::MANT_BITS), _mm256_set1_epi32(fb::EXP_BIAS)));
+
+   __m256i mantBits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(fb::MANT_MASK)), _mm256_set1_epi32(fb::ONE_BITS));
+   __m256 t = _mm256_sub_ps(_mm256_castsi256_ps(mantBits), _mm256_set1_ps(1.0f));
+
+   __m256 poly = _mm256_set1_ps(LOG2_C4);
+   poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(LOG2_C3));
+   poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(LOG2_C2));
+   poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(LOG2_C1));
+   poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(LOG2_C0));
+   __m256 result = _mm256_add_ps(exponent, _mm256_mul_ps(t, poly));
+
+   // Pass NaN / inf through (exponent field all ones) and make 0 -inf.
+   const __m256i expFieldMask = _mm256_set1_epi32(int(fb::EXP_MASK << fb::MANT_BITS));
+   __m256 notFinite = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(bits, expFieldMask), expFieldMask));
+   __m256 isZero = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ);
+   result = _mm256_blendv_ps(result, x, notFinite);
+   return _mm256_blendv_ps(result, _mm256_set1_ps(-std::numeric_limits<float>::infinity()), isZero);
+}
+
+AVX2_FUNC static size_t powerToDbAvx2(const double* fftOut, double* dB, size_t numBins, double dBOffset, double& minDb, double& maxDb)
+{
+   const __m256d scale = _mm256_set1_pd(DB_PER_LOG2);
+   const __m256d offset = _mm256_set1_pd(dBOffset);
+   __m256d minVal = _mm256_set1_pd(minDb);
+   __m256d maxVal = _mm256_set1_pd(maxDb);
+   size_t i = 0;
+   for(; i + 4 <= numBins; i += 4)
+   {
+      __m256d a = _mm256_loadu_pd(fftOut + 2*i);     // re0 im0 re1 im1
+      __m256d b = _mm256_loadu_pd(fftOut + 2*i + 4); // re2 im2 re3 im3
+      // hadd gives bins 0 2 1 3, permute back to 0 1 2 3.
+      __m256d power = _mm256_permute4x64_pd(_mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b)), 0xD8);
+      __m256d val = _mm256_add_pd(_mm256_mul_pd(fastLog2Avx2(power), scale), offset);
+      _mm256_storeu_pd(dB + i, val);
+      // min / max return the 2nd operand when either is NaN, so a NaN val is ignored (like std::min / std::max).
+      minVal = _mm256_min_pd(val, minVal);
+      maxVal = _mm256_max_pd(val, maxVal);
+   }
+
+   // Reduce the vectors down to a single min / max.
+   __m128d min2 = _mm_min_pd(_mm256_castpd256_pd128(minVal), _mm256_extractf128_pd(minVal, 1));
+   __m128d max2 = _mm_max_pd(_mm256_castpd256_pd128(maxVal), _mm256_extractf128_pd(maxVal, 1));
+   minDb = _mm_cvtsd_f64(_mm_min_sd(min2, _mm_unpackhi_pd(min2, min2)));
+   maxDb = _mm_cvtsd_f64(_mm_max_sd(max2, _mm_unpackhi_pd(max2, max2)));
+   return i;
+}
+
+AVX2_FUNC static size_t powerToDbAvx2(const float* fftOut, float* dB, size_t numBins, float dBOffset, float& minDb, float& maxDb)
+{
+   const __m256 scale = _mm256_set1_ps(DB_PER_LOG2);
+   const __m256 offset = _mm256_set1_ps(dBOffset);
+   __m256 minVal = _mm256_set1_ps(minDb);
+   __m256 maxVal = _mm256_set1_ps(maxDb);
+   size_t i = 0;
+   for(; i + 8 <= numBins; i += 8)
+   {
+      __m256 a = _mm256_loadu_ps(fftOut + 2*i);     // bins 0 - 3
+      __m256 b = _mm256_loadu_ps(fftOut + 2*i + 8); // bins 4 - 7
+      // hadd gives bins 0 1 4 5 2 3 6 7, permute the pairs back to 0 1 2 3 4 5 6 7.
+      __m256 power = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+      power = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(power), 0xD8));
+      __m256 val = _mm256_add_ps(_mm256_mul_ps(fastLog2Avx2(power), scale), offset);
+      _mm256_storeu_ps(dB + i, val);
+      minVal = _mm256_min_ps(val, minVal);
+      maxVal = _mm256_max_ps(val, maxVal);
+   }
+
+   // Reduce the vectors down to a single min / max.
+   __m128 min4 = _mm_min_ps(_mm256_castps256_ps128(minVal), _mm256_extractf128_ps(minVal, 1));
+   __m128 max4 = _mm_max_ps(_mm256_castps256_ps128(maxVal), _mm256_extractf128_ps(maxVal, 1));
+   min4 = _mm_min_ps(min4, _mm_movehl_ps(min4, min4));
+   max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+   minDb = _mm_cvtss_f32(_mm_min_ss(min4, _mm_shuffle_ps(min4, min4, 1)));
+   maxDb = _mm_cvtss_f32(_mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1)));
+   return i;
+}
+
+// Power of 4 doubles / 8 floats of interleaved FFT output (same shuffles as powerToDbAvx2).
+AVX2_FUNC static inline __m256d powerAvx2(const double* fftOut)
+{
+   __m256d a = _mm256_loadu_pd(fftOut);
+   __m256d b = _mm256_loadu_pd(fftOut + 4);
+   return _mm256_permute4x64_pd(_mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b)), 0xD8);
+}
+
+AVX2_FUNC static inline __m256 powerAvx2(const float* fftOut)
+{
+   __m256 a = _mm256_loadu_ps(fftOut);
+   __m256 b = _mm256_loadu_ps(fftOut + 8);
+   __m256 power = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+   return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(power), 0xD8));
+}
+
+AVX2_FUNC static size_t combinePowerAvx2(const double* fftOut, double* power, size_t numBins, ePowerCombine combine, bool first)
+{
+   size_t i = 0;
+   for(; i + 4 <= numBins; i += 4)
+   {
+      __m256d val = powerAvx2(fftOut + 2*i);
+      if(!first)
+      {
+         __m256d prev = _mm256_loadu_pd(power + i);
+         if(combine == E_COMBINE_MEAN)
+            val = _mm256_add_pd(prev, val);
+         else if(combine == E_COMBINE_MAX)
+            val = _mm256_max_pd(prev, val);
+         else
+            val = _mm256_min_pd(prev, val);
+      }
+      _mm256_storeu_pd(power + i, val);
+   }
+   return i;
+}
+
+AVX2_FUNC static size_t combinePowerAvx2(const float* fftOut, float* power, size_t numBins, ePowerCombine combine, bool first)
+{
+   size_t i = 0;
+   for(; i + 8 <= numBins; i += 8)
+   {
+      __m256 val = powerAvx2(fftOut + 2*i);
+      if(!first)
+      {
+         __m256 prev = _mm256_loadu_ps(power + i);
+         if(combine == E_COMBINE_MEAN)
+            val = _mm256_add_ps(prev, val);
+         else if(combine == E_COMBINE_MAX)
+            val = _mm256_max_ps(prev, val);
+         else
+            val = _mm256_min_ps(prev, val);
+      }
+      _mm256_storeu_ps(power + i, val);
+   }
+   return i;
+}
+
+AVX2_FUNC static size_t linearToDbAvx2(const double* power, double* dB, size_t num, double dBOffset, double& minDb, double& maxDb)
+{
+   const __m256d scale = _mm256_set1_pd(DB_PER_LOG2);
+   const __m256d offset = _mm256_set1_pd(dBOffset);
+   __m256d minVal = _mm256_set1_pd(minDb);
+   __m256d maxVal = _mm256_set1_pd(maxDb);
+   size_t i = 0;
+   for(; i + 4 <= num; i += 4)
+   {
+      __m256d val = _mm256_add_pd(_mm256_mul_pd(fastLog2Avx2(_mm256_loadu_pd(power + i)), scale), offset);
+      _mm256_storeu_pd(dB + i, val);
+      minVal = _mm256_min_pd(val, minVal);
+      maxVal = _mm256_max_pd(val, maxVal);
+   }
+
+   __m128d min2 = _mm_min_pd(_mm256_castpd256_pd128(minVal), _mm256_extractf128_pd(minVal, 1));
+   __m128d max2 = _mm_max_pd(_mm256_castpd256_pd128(maxVal), _mm256_extractf128_pd(maxVal, 1));
+   minDb = _mm_cvtsd_f64(_mm_min_sd(min2, _mm_unpackhi_pd(min2, min2)));
+   maxDb = _mm_cvtsd_f64(_mm_max_sd(max2, _mm_unpackhi_pd(max2, max2)));
+   return i;
+}
+
+AVX2_FUNC static size_t linearToDbAvx2(const float* power, float* dB, size_t num, float dBOffset, float& minDb, float& maxDb)
+{
+   const __m256 scale = _mm256_set1_ps(DB_PER_LOG2);
+   const __m256 offset = _mm256_set1_ps(dBOffset);
+   __m256 minVal = _mm256_set1_ps(minDb);
+   __m256 maxVal = _mm256_set1_ps(maxDb);
+   size_t i = 0;
+   for(; i + 8 <= num; i += 8)
+   {
+      __m256 val = _mm256_add_ps(_mm256_mul_ps(fastLog2Avx2(_mm256_loadu_ps(power + i)), scale), offset);
+      _mm256_storeu_ps(dB + i, val);
+      minVal = _mm256_min_ps(val, minVal);
+      maxVal = _mm256_max_ps(val, maxVal);
+   }
+
+   __m128 min4 = _mm_min_ps(_mm256_castps256_ps128(minVal), _mm256_extractf128_ps(minVal, 1));
+   __m128 max4 = _mm_max_ps(_mm256_castps256_ps128(maxVal), _mm256_extractf128_ps(maxVal, 1));
+   min4 = _mm_min_ps(min4, _mm_movehl_ps(min4, min4));
+   max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+   minDb = _mm_cvtss_f32(_mm_min_ss(min4, _mm_shuffle_ps(min4, min4, 1)));
+   maxDb = _mm_cvtss_f32(_mm_max_ss(max4, _mm_shuffle_ps(max4, max4, 1)));
+   return i;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+void convertAndWindow(const tSampType* iqSamples, const tFftType* window, tFftType* fftIn, size_t numValues)
+{
+   size_t numDone = 0;
+#ifdef FFT_KERNELS_X86
+   if constexpr(Avx2Load<tSampType>::valid)
+   {
+      if(cpuHasAvx2())
+         numDone = convertAndWindowAvx2(iqSamples, window, fftIn, numValues);
+   }
+#endif
+   convertAndWindowScalar(iqSamples+numDone, window+numDone, fftIn+numDone, numValues-numDone);
+}
+
+template<typename tFftType>
+void powerToDb(const tFftType* fftOut, tFftType* dB, size_t numBins, tFftType dBOffset, tFftType& minDb, tFftType& maxDb)
+{
+   size_t numDone = 0;
+#ifdef FFT_KERNELS_X86
+   if(cpuHasAvx2())
+      numDone = powerToDbAvx2(fftOut, dB, numBins, dBOffset, minDb, maxDb);
+#endif
+   powerToDbScalar(fftOut+2*numDone, dB+numDone, numBins-numDone, dBOffset, minDb, maxDb);
+}
+
+template void powerToDb<double>(const double*, double*, size_t, double, double&, double&);
+template void powerToDb<float>(const float*, float*, size_t, float, float&, float&);
+
+template<typename tFftType>
+void combinePower(const tFftType* fftOut, tFftType* power, size_t numBins, ePowerCombine combine, bool first)
+{
+   size_t numDone = 0;
+#ifdef FFT_KERNELS_X86
+   if(cpuHasAvx2())
+      numDone = combinePowerAvx2(fftOut, power, numBins, combine, first);
+#endif
+   combinePowerScalar(fftOut+2*numDone, power+numDone, numBins-numDone, combine, first);
+}
+
+template void combinePower<double>(const double*, double*, size_t, ePowerCombine, bool);
+template void combinePower<float>(const float*, float*, size_t, ePowerCombine, bool);
+
+template<typename tFftType>
+void linearToDb(const tFftType* power, tFftType* dB, size_t num, tFftType dBOffset, tFftType& minDb, tFftType& maxDb)
+{
+   size_t numDone = 0;
+#ifdef FFT_KERNELS_X86
+   if(cpuHasAvx2())
+      numDone = linearToDbAvx2(power, dB, num, dBOffset, minDb, maxDb);
+#endif
+   linearToDbScalar(power+numDone, dB+numDone, num-numDone, dBOffset, minDb, maxDb);
+}
+
+template void linearToDb<double>(const double*, double*, size_t, double, double&, double&);
+template void linearToDb<float>(const float*, float*, size_t, float, float&, float&);
+
+template<typename tFftType>
+void reduceBins(const tFftType* power, tFftType* out, size_t numIn, size_t numOut, eBinReduce reduce)
+{
+   const tFftType PEAK_RATIO = tFftType(10); // 10 dB above the average
+   size_t beginIn = 0;
+   for(size_t i = 0; i < numOut; ++i)
+   {
+      size_t endIn = (i+1)*numIn/numOut;
+      tFftType sum = 0;
+      tFftType maxVal = power[beginIn];
+      for(size_t j = beginIn; j < endIn; ++j)
+      {
+         sum += power[j];
+         maxVal = std::max(maxVal, power[j]);
+      }
+      tFftType mean = sum / tFftType(endIn - beginIn);
+      if(reduce == E_REDUCE_MAX)
+         out[i] = maxVal;
+      else if(reduce == E_REDUCE_MEAN)
+         out[i] = mean;
+      else
+         out[i] = maxVal > mean * PEAK_RATIO ? maxVal : mean;
+      beginIn = endIn;
+   }
+}
+
+template void reduceBins<double>(const double*, double*, size_t, size_t, eBinReduce);
+template void reduceBins<float>(const float*, float*, size_t, size_t, eBinReduce);
+
+template<typename tFftType>
+void dbToLevel(const tFftType* dB, uint8_t* level, size_t num, double minDb, double deltaDb)
+{
+   for(size_t i = 0; i < num; ++i)
+   {
+      level[i] = dbToLevel(double(dB[i]), minDb, deltaDb);
+   }
+}
+
+template void dbToLevel<double>(const double*, uint8_t*, size_t, double, double);
+template void dbToLevel<float>(const float*, uint8_t*, size_t, double, double);
+
+// Explicit Instantiations for all the supported types.
+#define FFT_KERNELS_INSTANTIATE(tSampType) \
+   template void convertAndWindow<tSampType, double>(const tSampType*, const double*, double*, size_t); \
+   template void convertAndWindow<tSampType, float>(const tSampType*, const float*, float*, size_t);
+
+FFT_KERNELS_INSTANTIATE(int8_t)
+FFT_KERNELS_INSTANTIATE(int16_t)
+FFT_KERNELS_INSTANTIATE(int32_t)
+FFT_KERNELS_INSTANTIATE(int64_t)
+FFT_KERNELS_INSTANTIATE(uint8_t)
+FFT_KERNELS_INSTANTIATE(uint16_t)
+FFT_KERNELS_INSTANTIATE(uint32_t)
+FFT_KERNELS_INSTANTIATE(uint64_t)
+FFT_KERNELS_INSTANTIATE(float)
+FFT_KERNELS_INSTANTIATE(double)
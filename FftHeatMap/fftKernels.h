@@ -0,0 +1,85 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Vectorized per FFT processing steps. AVX2 versions are picked at runtime when the CPU supports
+// them, otherwise plain C++ loops are used.
+//
+// Supported tSampType: int8_t, int16_t, int32_t, int64_t, uint8_t, uint16_t, uint32_t, uint64_t, float, double
+// Supported tFftType: double, float
+
+// Converts interleaved IQ samples to tFftType and multiplies them by the window in one pass. The
+// window must be interleaved the same way as the samples (i.e. window[2*i] == window[2*i+1]) so the
+// output can go straight into an interleaved FFTW input buffer. 'numValues' is 2x the number of IQ samples.
+template<typename tSampType, typename tFftType>
+void convertAndWindow(const tSampType* iqSamples, const tFftType* window, tFftType* fftIn, size_t numValues);
+
+// Converts interleaved complex FFT output bins to power in dB, i.e. 10*log10(re^2 + im^2) + dBOffset.
+// log10 is approximated from the float's exponent plus a polynomial for the mantissa (max error is
+// about 0.00005 dB, far below one color level). minDb / maxDb are updated with the min / max dB values
+// of these bins (they are not reset, initialize them to +inf / -inf).
+template<typename tFftType>
+void powerToDb(const tFftType* fftOut, tFftType* dB, size_t numBins, tFftType dBOffset, tFftType& minDb, tFftType& maxDb);
+
+// How the power of multiple FFTs is combined into one.
+typedef enum
+{
+   E_COMBINE_MEAN, // Average linear power (Welch averaging)
+   E_COMBINE_MAX,  // Max hold
+   E_COMBINE_MIN   // Min hold
+}ePowerCombine;
+
+// Combines the power (re^2 + im^2) of interleaved complex FFT output bins into 'power'. MEAN sums
+// the power (divide by the number of FFTs later, i.e. as a dB offset). 'first' overwrites 'power'
+// instead of combining with it.
+template<typename tFftType>
+void combinePower(const tFftType* fftOut, tFftType* power, size_t numBins, ePowerCombine combine, bool first);
+
+// Converts linear power values to dB, i.e. 10*log10(power) + dBOffset, with the same approximation
+// and min / max tracking as powerToDb.
+template<typename tFftType>
+void linearToDb(const tFftType* power, tFftType* dB, size_t num, tFftType dBOffset, tFftType& minDb, tFftType& maxDb);
+
+// How adjacent FFT bins are reduced down to a single output bin.
+typedef enum
+{
+   E_REDUCE_MAX,  // Strongest bin
+   E_REDUCE_MEAN, // Average linear power
+   E_REDUCE_PEAK  // Average, unless the strongest bin stands well above the average (i.e. a narrowband signal)
+}eBinReduce;
+
+// Reduces 'numIn' linear power values to 'numOut' values (numOut <= numIn). Output value i covers
+// input values [i*numIn/numOut, (i+1)*numIn/numOut), so the ratio doesn't need to be an integer.
+template<typename tFftType>
+void reduceBins(const tFftType* power, tFftType* out, size_t numIn, size_t numOut, eBinReduce reduce);
+
+// Maps a dB value to a color level. minDb + deltaDb (and above) maps to level 0, minDb (and below) maps to level 255.
+inline uint8_t dbToLevel(double dB, double minDb, double deltaDb)
+{
+   double normVal = (dB - minDb) / deltaDb;
+   if(normVal > 1.0){normVal = 1.0;}
+   if(!(normVal > 0.0)){normVal = 0.0;} // Also catches NaN
+   return uint8_t((1.0-normVal)*255.0);
+}
+
+template<typename tFftType>
+void dbToLevel(const tFftType* dB, uint8_t* level, size_t num, double minDb, double deltaDb);
@@ -1,5 +1,6 @@
 import os
 import argparse
+import tempfile
 from datetime import datetime
 
 ################################################################################
@@ -68,6 +69,15 @@ def main():
    parser.add_argument("-S", "--start_offset", type=int, help="In File Start Position.")
    parser.add_argument("-E", "--end_offset", type=int, help="In File End Position.")
    parser.add_argument("-M", "--max_ffts", type=int, help="If specified, the output will be split into multiple files.")
+   parser.add_argument("-p", "--plan_effort", help="FFT Plan Effort (estimate, measure, patient).")
+   parser.add_argument("-w", "--wisdom", help="FFTW Wisdom file (loaded at startup, saved on exit).")
+   parser.add_argument("-d", "--precision", help="FFT Precision (double or float).")
+   parser.add_argument("-q", "--fast_png", action='store_true', help="Fast PNG encoding (faster, but bigger files).")
+   parser.add_argument("-c", "--ffts_per_row", type=int, help="Number of FFTs to combine into each row of the Heat Map.")
+   parser.add_argument("-C", "--row_combine", help="How the FFTs in a row are combined (mean, max, min).")
+   parser.add_argument("-W", "--width", type=int, help="Number of frequency bins in the Heat Map.")
+   parser.add_argument("-B", "--bin_reduce", help="How FFT bins are reduced down to the width (max, mean, peak).")
+   parser.add_argument("-Z", "--tile_size", type=int, help="If specified, the output will be a directory with a tile pyramid (zoom/x/y.png).")
    args = parser.parse_args()
 
    # Get a unique time based str that can be used
@@ -116,6 +126,24 @@ def main():
       fixedArgs += (' -E ' + str(args.end_offset))
    if args.max_ffts != None:
       fixedArgs += (' -M ' + str(args.max_ffts))
+   if args.plan_effort != None:
+      fixedArgs += (' -p ' + str(args.plan_effort))
+   if args.wisdom != None:
+      fixedArgs += (' -w ' + str(args.wisdom))
+   if args.precision != None:
+      fixedArgs += (' -d ' + str(args.precision))
+   if args.fast_png == True:
+      fixedArgs += (' -q')
+   if args.ffts_per_row != None:
+      fixedArgs += (' -c ' + str(args.ffts_per_row))
+   if args.row_combine != None:
+      fixedArgs += (' -C ' + str(args.row_combine))
+   if args.width != None:
+      fixedArgs += (' -W ' + str(args.width))
+   if args.bin_reduce != None:
+      fixedArgs += (' -B ' + str(args.bin_reduce))
+   if args.tile_size != None:
+      fixedArgs += (' -Z ' + str(args.tile_size))
 
    # Figure out base directory to store output files.
    outBaseDir = None
@@ -144,16 +172,27 @@ def main():
       # User didn't specify an output directory, it will be relative to the input file(s)
       pass # Nothing to do
 
-   # Loop over the input files.
-   for inFile in filesToParse:
-      # Determine output directory
+   if os.path.isfile(args.input):
+      # Single file.
+      inFile = filesToParse[0]
       outDir = os.path.dirname(inFile) if outBaseDir == None else outBaseDir
-
-      # Single file. Not making a new directory here.
       outFileName = outFileName if outFileName != None else os.path.split(inFile)[1]
 
       cmdLine = app_path + ' -i ' + inFile + ' -o ' + os.path.join(outDir, outFileName) + fixedArgs
       os.system(cmdLine)
+   else:
+      # Multiple files. Pass them all to the app in a list file, the app processes them in a single
+      # process (sharing the worker threads and FFT plans between the files).
+      with tempfile.NamedTemporaryFile(mode='w', suffix='.txt', delete=False) as listFile:
+         for inFile in filesToParse:
+            listFile.write(inFile + '\n')
+         listPath = listFile.name
+
+      cmdLine = app_path + ' -l ' + listPath + fixedArgs
+      if args.output != None:
+         cmdLine += ' -o ' + args.output # Output directory. Otherwise each output goes next to its input file.
+      os.system(cmdLine)
+      os.remove(listPath)
 
 
 
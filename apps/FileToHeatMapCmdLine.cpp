@@ -17,20 +17,296 @@
  * DEALINGS IN THE SOFTWARE.
  */
 #include <unistd.h>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+#include <functional>
 #include "FileToHeatMap.h"
+#include "StreamToHeatMap.h"
+#include "HeatMapJobs.h"
 
+// A file is split across all the workers when it has at least this many FFTs per worker. Smaller
+// files are run in parallel, one file per worker.
+static constexpr size_t LARGE_FILE_FFTS_PER_THREAD = 256;
 
-template<typename tSampType>
-void GenHeatMap(tFileToHeatMapConfig& config, const std::string& outPath, uint32_t maxFileSize)
+// Incremental output is always split into files, this is the file size when -M isn't specified.
+static constexpr uint32_t DEFAULT_INCREMENTAL_FFTS_PER_FILE = 1024;
+
+// Returns the current set of jobs (in follow mode new files can show up between passes).
+typedef std::function<std::vector<tHeatMapJob>()> tGetJobsFunc;
+
+typedef struct tOutputConfig
+{
+   uint32_t maxFileSize = 0; // 0 means don't split into smaller files.
+   uint32_t tileSize = 0; // 0 means don't write a tile pyramid.
+   bool incremental = false; // Only process the samples added since the last run (see GenHeatMapIncremental).
+   double followSeconds = 0; // If > 0, keep checking the input for new samples this often.
+   bool saveDbCache = false; // Save the dB values to <output>.dbcache so they can be rendered again without the FFTs.
+   bool renderFromCache = false; // The input is a dB cache file, only render it.
+}tOutputConfig;
+
+// The state file remembers how many of the output files are complete and how big the input was at
+// the time. It is only valid for the same settings, so the settings are stored along with it.
+static std::string GetStateSettings(const tFileToHeatMapConfig& config, uint32_t maxFileSize, size_t sampSize, size_t fftTypeSize)
+{
+   return std::to_string(config.sampleRate) + " " + std::to_string(config.fftSize) + " " + std::to_string(config.timeBetweenFfts) + " " +
+          std::to_string(config.startPosition) + " " + std::to_string(config.maxLevelDb) + " " + std::to_string(config.rangeDb) + " " +
+          std::to_string(config.fftsPerRow) + " " + std::to_string(config.rowCombine) + " " + std::to_string(config.outputWidth) + " " +
+          std::to_string(config.binReduce) + " " + std::to_string(maxFileSize) + " " + std::to_string(sampSize) + " " + std::to_string(fftTypeSize);
+}
+
+static bool LoadState(const std::string& statePath, const std::string& settings, size_t& numCompleteFiles, size_t& inputSize)
+{
+   std::ifstream stateFile(statePath);
+   std::string stateSettings;
+   if(std::getline(stateFile, stateSettings) && stateSettings == settings && (stateFile >> numCompleteFiles >> inputSize))
+      return true;
+   numCompleteFiles = 0; // No state (or different settings), start from the beginning.
+   return false;
+}
+
+static void SaveState(const std::string& statePath, const std::string& settings, size_t numCompleteFiles, size_t inputSize)
+{
+   // Write the new state next to the old one and then replace it, so the state is never partial.
+   std::string tempPath = statePath + ".tmp";
+   {
+      std::ofstream stateFile(tempPath);
+      stateFile << settings << "\n" << numCompleteFiles << " " << inputSize << "\n";
+   }
+   rename(tempPath.c_str(), statePath.c_str());
+}
+
+// Heat map of an input file that is still being written. The output is split into files, files
+// that are complete (see genHeatMapPngSplit) are recorded in a state file next to the output and
+// are skipped from then on. Only the new files and the last partial file are generated, so the
+// cost of each update is proportional to the new samples rather than the size of the input.
+template<typename tSampType, typename tFftType>
+void GenHeatMapIncremental(tFileToHeatMapConfig& config, const std::string& outPath, const tOutputConfig& output, std::shared_ptr<WorkerPool> workerPool)
+{
+   if(config.normalizeHeatMap || config.autoScale)
+   {
+      printf("Incremental mode needs a fixed scale (can't normalize or auto scale)\n");
+      return;
+   }
+   uint32_t maxFileSize = output.maxFileSize != 0 ? output.maxFileSize : DEFAULT_INCREMENTAL_FFTS_PER_FILE;
+   std::string statePath = outPath + ".state";
+   std::string settings = GetStateSettings(config, maxFileSize, sizeof(tSampType), sizeof(tFftType));
+   size_t numCompleteFiles = 0;
+   size_t lastInputSize = 0;
+   bool validState = LoadState(statePath, settings, numCompleteFiles, lastInputSize);
+
+   std::error_code ec;
+   size_t inputSize = std::filesystem::file_size(config.filePath, ec);
+   if(ec || (validState && inputSize == lastInputSize))
+      return; // Nothing new.
+   bool restart = validState && inputSize < lastInputSize;
+   if(restart)
+   {
+      // The input was truncated or replaced, the completed files no longer match it. Start over.
+      numCompleteFiles = 0;
+      validState = false;
+   }
+
+   FileToHeatMap<tSampType, tFftType> f2hm(config, workerPool);
+   numCompleteFiles = f2hm.genHeatMapPngSplit(outPath, maxFileSize, true, numCompleteFiles);
+   SaveState(statePath, settings, numCompleteFiles, inputSize);
+
+   if(restart)
+   {
+      // Remove the files of the old input past the end of the new one, so the output is only the new input.
+      size_t numFiles = (f2hm.getNumFfts() + maxFileSize - 1) / maxFileSize;
+      for(size_t fileIndex = numFiles; std::filesystem::remove(outPath + "_" + std::to_string(fileIndex) + ".png", ec); ++fileIndex);
+   }
+}
+
+
+template<typename tSampType, typename tFftType>
+void GenHeatMap(tFileToHeatMapConfig& config, const std::string& outPath, const tOutputConfig& output, std::shared_ptr<WorkerPool> workerPool)
 {
-   FileToHeatMap<tSampType> f2hm(config);
-   f2hm.genHeatMap();
-   if(maxFileSize == 0)
+   if(output.incremental)
+   {
+      GenHeatMapIncremental<tSampType, tFftType>(config, outPath, output, workerPool);
+      return;
+   }
+
+   uint32_t maxFileSize = output.maxFileSize;
+   config.storeDb = output.saveDbCache;
+   config.renderFromDbCache = output.renderFromCache;
+   FileToHeatMap<tSampType, tFftType> f2hm(config, workerPool);
+   if(output.renderFromCache)
+   {
+      if(!f2hm.loadDbCache(config.filePath))
+      {
+         printf("Invalid dB cache file: %s\n", config.filePath.c_str());
+         return;
+      }
+   }
+   else if(maxFileSize != 0 && output.tileSize == 0 && !config.normalizeHeatMap && !config.autoScale && !output.saveDbCache)
+   {
+      // The scaling is known up front, write out each file as soon as its FFTs are done.
+      f2hm.genHeatMapPngSplit(outPath, maxFileSize, true);
+      return;
+   }
+   else
+   {
+      f2hm.genHeatMap();
+      if(output.saveDbCache)
+         f2hm.saveDbCache(outPath + ".dbcache");
+   }
+
+   if(output.tileSize != 0)
+      f2hm.savePngPyramid(outPath, output.tileSize, true);
+   else if(maxFileSize == 0)
       f2hm.savePng(outPath + ".png", true);
    else
       f2hm.savePngSplit(outPath, maxFileSize, true);
 }
 
+template<typename tSampType, typename tFftType>
+void GenHeatMaps(const tFileToHeatMapConfig& config, std::vector<tHeatMapJob> jobs, const tGetJobsFunc& getJobs, const tOutputConfig& output)
+{
+   // One pool (and so one set of FFTW plans per worker thread) for all the files.
+   auto workerPool = std::make_shared<WorkerPool>(std::max(size_t(1), config.numThreads), config.workerAffinity);
+   size_t numThreads = workerPool->getNumThreads();
+
+   // Large files have enough FFTs to keep all the workers busy, run them one at a time on the
+   // whole pool. Run the small files in parallel, each on a single worker.
+   size_t sampBetweenFfts = std::max(size_t(1), size_t(config.sampleRate * config.timeBetweenFfts + 0.5));
+   size_t largeFileBytes = 2*sizeof(tSampType) * sampBetweenFfts * LARGE_FILE_FFTS_PER_THREAD * numThreads;
+   while(1)
+   {
+      std::vector<const tHeatMapJob*> largeJobs;
+      std::vector<const tHeatMapJob*> smallJobs;
+      for(auto& job : jobs)
+      {
+         std::error_code ec;
+         size_t fileSize = std::filesystem::file_size(job.inPath, ec);
+         if(jobs.size() == 1 || numThreads == 1 || (!ec && fileSize >= largeFileBytes))
+            largeJobs.push_back(&job);
+         else
+            smallJobs.push_back(&job);
+      }
+
+      workerPool->parallelFor(smallJobs.size(), 1, [&](size_t workerIndex, size_t beginJob, size_t endJob)
+      {
+         auto inlinePool = std::make_shared<WorkerPool>(0); // Already on a worker, run the heat map on this thread.
+         for(size_t jobIndex = beginJob; jobIndex < endJob; ++jobIndex)
+         {
+            tFileToHeatMapConfig jobConfig = config;
+            jobConfig.filePath = smallJobs[jobIndex]->inPath;
+            GenHeatMap<tSampType, tFftType>(jobConfig, smallJobs[jobIndex]->outPath, output, inlinePool);
+         }
+      });
+
+      for(auto job : largeJobs)
+      {
+         tFileToHeatMapConfig jobConfig = config;
+         jobConfig.filePath = job->inPath;
+         GenHeatMap<tSampType, tFftType>(jobConfig, job->outPath, output, workerPool);
+      }
+
+      // Follow mode, keep picking up the new samples (the inputs are incremental, so only new samples are processed).
+      // The jobs are found again every pass, so new files in a followed directory / list are picked up.
+      if(output.followSeconds <= 0)
+         break;
+      std::this_thread::sleep_for(std::chrono::duration<double>(output.followSeconds));
+      jobs = getJobs();
+   }
+}
+
+template<typename tSampType>
+void RenderDbCache(tFileToHeatMapConfig& config, const tHeatMapJob& job, const tOutputConfig& output, bool singlePrecision, std::shared_ptr<WorkerPool> workerPool)
+{
+   if(singlePrecision)
+      GenHeatMap<tSampType, float>(config, job.outPath, output, workerPool);
+   else
+      GenHeatMap<tSampType, double>(config, job.outPath, output, workerPool);
+}
+
+// The sample type a dB cache file was made with (as the -y string).
+static std::string GetDbCacheSampType(const tDbCacheHeader& header)
+{
+   if(header.sampTypeIsFloat)
+      return header.sampTypeSize == sizeof(float) ? "float" : "double";
+   return std::string(header.sampTypeIsSigned ? "int" : "uint") + std::to_string(8*header.sampTypeSize) + "_t";
+}
+
+// Render only (-R). Each input is a dB cache file, the types and FFT settings come from its header
+// (so -y, -s, -f and -t aren't needed).
+static void RenderDbCaches(const tFileToHeatMapConfig& config, const std::vector<tHeatMapJob>& jobs, const tOutputConfig& output)
+{
+   auto workerPool = std::make_shared<WorkerPool>(std::max(size_t(1), config.numThreads), config.workerAffinity);
+   for(auto& job : jobs)
+   {
+      tDbCacheHeader header;
+      if(!readDbCacheHeader(job.inPath, header))
+      {
+         printf("Invalid dB cache file: %s\n", job.inPath.c_str());
+         continue;
+      }
+      tFileToHeatMapConfig jobConfig = config;
+      jobConfig.filePath = job.inPath;
+      std::string sampType = GetDbCacheSampType(header);
+      bool singlePrecision = header.fftTypeSize == sizeof(float);
+           if(sampType == "int8_t")   {RenderDbCache<int8_t>  (jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "int16_t")  {RenderDbCache<int16_t> (jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "int32_t")  {RenderDbCache<int32_t> (jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "int64_t")  {RenderDbCache<int64_t> (jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "uint8_t")  {RenderDbCache<uint8_t> (jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "uint16_t") {RenderDbCache<uint16_t>(jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "uint32_t") {RenderDbCache<uint32_t>(jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "uint64_t") {RenderDbCache<uint64_t>(jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "float")    {RenderDbCache<float>   (jobConfig, job, output, singlePrecision, workerPool);}
+      else if(sampType == "double")   {RenderDbCache<double>  (jobConfig, job, output, singlePrecision, workerPool);}
+      else{printf("Invalid dB cache file: %s\n", job.inPath.c_str());}
+   }
+}
+
+// stdin ("-") and named pipes can't be seeked / sized, they are processed as a stream.
+static bool IsStream(const std::string& inPath)
+{
+   std::error_code ec;
+   return inPath == "-" || std::filesystem::is_fifo(inPath, ec);
+}
+
+template<typename tSampType, typename tFftType>
+void GenWaterfall(const tFileToHeatMapConfig& config, tStreamToHeatMapConfig streamConfig, const tHeatMapJob& job)
+{
+   streamConfig.inputPath = job.inPath;
+   streamConfig.sampleRate = config.sampleRate;
+   streamConfig.fftSize = config.fftSize;
+   streamConfig.timeBetweenFfts = config.timeBetweenFfts;
+   streamConfig.numThreads = config.numThreads;
+   streamConfig.maxLevelDb = config.maxLevelDb;
+   streamConfig.rangeDb = config.rangeDb;
+   streamConfig.fftBatchSize = config.fftBatchSize;
+   streamConfig.fastPngEncode = config.fastPngEncode;
+   streamConfig.profiler = config.profiler;
+   streamConfig.workerAffinity = config.workerAffinity;
+
+   StreamToHeatMap<tSampType, tFftType> s2hm(streamConfig);
+   s2hm.run(job.outPath + ".png");
+   fprintf(stderr, "Processed %zu FFTs, dropped %zu FFTs\n", s2hm.getNumFfts(), s2hm.getNumDropped());
+}
+
+template<typename tSampType>
+void GenHeatMaps(const tFileToHeatMapConfig& config, const std::vector<tHeatMapJob>& jobs, const tGetJobsFunc& getJobs, const tOutputConfig& output, bool singlePrecision, const tStreamToHeatMapConfig& streamConfig)
+{
+   if(jobs.size() == 1 && IsStream(jobs[0].inPath))
+   {
+      if(singlePrecision)
+         GenWaterfall<tSampType, float>(config, streamConfig, jobs[0]);
+      else
+         GenWaterfall<tSampType, double>(config, streamConfig, jobs[0]);
+      return;
+   }
+
+   if(singlePrecision)
+      GenHeatMaps<tSampType, float>(config, jobs, getJobs, output);
+   else
+      GenHeatMaps<tSampType, double>(config, jobs, getJobs, output);
+}
+
 int main(int argc, char *argv[])
 {
    tFileToHeatMapConfig config;
@@ -41,10 +317,16 @@ int main(int argc, char *argv[])
    config.startPosition = 0;
    config.endPosition = 0;
    std::string outPath;
+   std::string listPath; // File with a list of input files (one per line).
+   tStreamToHeatMapConfig streamConfig; // Only used when the input is stdin or a named pipe.
    std::string inputFormat;
-   uint32_t maxFileSize = 0; // 0 means don't split into smaller files.
+   tOutputConfig output;
+   std::string wisdomPath; // Empty means don't load / save FFTW wisdom.
+   bool singlePrecision = false;
+   std::string profileSummaryPath; // Empty means no per stage timing.
+   std::string profileTracePath; // Empty means no trace events.
 
-   const char* argStr = "i:o:s:f:t:j:y:nm:r:S:E:M:h";
+   const char* argStr = "i:o:s:f:t:j:y:nm:r:S:E:M:p:w:b:xd:qc:C:W:B:Z:l:H:u:IF:KRT:P:aA:k:NU:h";
    int option = -1;
    while((option = getopt(argc, argv, argStr)) != -1)
    {
@@ -87,13 +369,143 @@ int main(int argc, char *argv[])
          config.endPosition = strtoll(optarg, nullptr, 10);
       break;
       case 'M':
-         maxFileSize = strtoul(optarg, nullptr, 10);
+         output.maxFileSize = strtoul(optarg, nullptr, 10);
+      break;
+      case 'p':
+         if(std::string(optarg) == "measure")
+            setFftPlanEffort(E_FFT_PLAN_MEASURE);
+         else if(std::string(optarg) == "patient")
+            setFftPlanEffort(E_FFT_PLAN_PATIENT);
+         else
+            setFftPlanEffort(E_FFT_PLAN_ESTIMATE);
+      break;
+      case 'w':
+         wisdomPath = std::string(optarg);
+      break;
+      case 'b':
+         config.fftBatchSize = strtoul(optarg, nullptr, 10);
+      break;
+      case 'x':
+         config.memoryMapInput = true;
+      break;
+      case 'd':
+         singlePrecision = (std::string(optarg) == "float");
+      break;
+      case 'q':
+         config.fastPngEncode = true;
+      break;
+      case 'c':
+         config.fftsPerRow = strtoul(optarg, nullptr, 10);
+      break;
+      case 'C':
+         if(std::string(optarg) == "max")
+            config.rowCombine = E_COMBINE_MAX;
+         else if(std::string(optarg) == "min")
+            config.rowCombine = E_COMBINE_MIN;
+         else
+            config.rowCombine = E_COMBINE_MEAN;
+      break;
+      case 'W':
+         config.outputWidth = strtoul(optarg, nullptr, 10);
+      break;
+      case 'B':
+         if(std::string(optarg) == "mean")
+            config.binReduce = E_REDUCE_MEAN;
+         else if(std::string(optarg) == "peak")
+            config.binReduce = E_REDUCE_PEAK;
+         else
+            config.binReduce = E_REDUCE_MAX;
+      break;
+      case 'Z':
+         output.tileSize = strtoul(optarg, nullptr, 10);
+      break;
+      case 'l':
+         listPath = std::string(optarg);
+      break;
+      case 'H':
+         streamConfig.numRows = strtoul(optarg, nullptr, 10);
+      break;
+      case 'u':
+         streamConfig.refreshSeconds = strtod(optarg, nullptr);
+      break;
+      case 'I':
+         output.incremental = true;
+      break;
+      case 'F':
+         output.incremental = true;
+         output.followSeconds = strtod(optarg, nullptr);
+      break;
+      case 'K':
+         output.saveDbCache = true;
+      break;
+      case 'R':
+         output.renderFromCache = true;
+      break;
+      case 'T':
+         profileSummaryPath = std::string(optarg);
+      break;
+      case 'P':
+         profileTracePath = std::string(optarg);
+      break;
+      case 'a':
+         config.autoScale = true;
+      break;
+      case 'A':
+      {
+         // "floor,top" percentiles
+         char* end = nullptr;
+         config.autoScale = true;
+         config.autoScaleFloor = strtod(optarg, &end);
+         if(end != nullptr && *end == ',')
+            config.autoScaleTop = strtod(end + 1, nullptr);
+      }
+      break;
+      case 'k':
+         if(std::string(optarg) == "core")
+            config.workerAffinity = WorkerPool::E_AFFINITY_CORE;
+         else if(std::string(optarg) == "node")
+            config.workerAffinity = WorkerPool::E_AFFINITY_NODE;
+         else
+            config.workerAffinity = WorkerPool::E_AFFINITY_NONE;
+      break;
+      case 'N':
+         config.numaFirstTouch = true;
+      break;
+      case 'U':
+         if(std::string(optarg) == "explicit")
+            config.hugePages = E_HUGE_PAGES_EXPLICIT;
+         else if(std::string(optarg) == "thp")
+            config.hugePages = E_HUGE_PAGES_TRANSPARENT;
+         else
+            config.hugePages = E_HUGE_PAGES_OFF;
       break;
       case 'h':
-         printf("Help:\n -i : input file\n -o : output file (extension will be added)\n -s : sample rate\n -f : FFT Size\n -t : Time Between FFTs\n"
+         printf("Help:\n -i : input file (or directory, all the files in it are processed). '-' or a named pipe generates a rolling waterfall\n -o : output file (extension will be added). Output directory when processing multiple files\n"
+             " -l : File with a list of input files (one per line)\n -s : sample rate\n -f : FFT Size\n -t : Time Between FFTs\n"
              " -y : Input Format (float, double, int16_t, etc)\n -j : Num Threads\n" 
              " -n : Use this to normalize max to the detected peak value.\n -m : Max FFT bin value in dB\n -r : Range of the Heat Map in dB\n"
-             " -S : In File Start Position\n -E : In File End Position\n -M : Max number of FFTs per file (this will split Heat Map into multiple files)\n" );
+             " -S : In File Start Position\n -E : In File End Position\n -M : Max number of FFTs per file (this will split Heat Map into multiple files)\n"
+             " -p : FFT Plan Effort (estimate, measure, patient)\n -w : FFTW Wisdom file (loaded at startup, saved on exit)\n"
+             " -b : Number of FFTs to run per FFTW call (0 or unspecified will pick based on FFT Size)\n"
+             " -x : Memory map the input file (workers read the samples directly from the mapping)\n"
+             " -d : FFT Precision (double or float)\n"
+             " -q : Fast PNG encoding (faster, but bigger files)\n"
+             " -c : Number of FFTs to combine into each row of the Heat Map\n -C : How the FFTs in a row are combined (mean, max, min)\n"
+             " -W : Number of frequency bins in the Heat Map (0 or unspecified will use the FFT Size)\n"
+             " -B : How FFT bins are reduced down to the -W width (max, mean, peak)\n"
+             " -Z : Tile Size. Writes a tile pyramid (output/zoom/x/y.png, zoom 0 is full resolution) instead of a single image\n"
+             " -H : Number of rows in the rolling waterfall (stdin / named pipe input)\n -u : Waterfall refresh period in seconds (stdin / named pipe input)\n"
+             " -I : Incremental. Only process the samples added to the input since the last run (output is split, see -M)\n"
+             " -F : Follow. Incremental, and keep checking the input for new samples every this many seconds\n"
+             " -K : Save the dB values to <output>.dbcache, so the Heat Map can be rendered again (-R) without running the FFTs (not with -I / -F)\n"
+             " -R : Render only. The input is a dB cache file (see -K), -y / -s / -f / -t come from the cache\n"
+             " -T : Save per stage timing and throughput (JSON) to this file on exit\n"
+             " -P : Save a trace of every stage on every thread (Chrome trace event JSON) to this file on exit\n"
+             " -a : Auto scale. The colors go from the median dB value (noise floor) to the 99.9th percentile (overrides -m, -r and -n)\n"
+             " -A : Auto scale with these percentiles, 'floor,top' (e.g. 50,99.9)\n"
+             " -k : Worker CPU affinity (none, core, node). core pins each worker to a core, node pins each worker to a NUMA node\n"
+             " -N : NUMA first touch. Each worker allocates its own buffers and first writes whole pages of the Heat Map\n"
+             " -U : Huge pages for the Heat Map buffers (off, thp, explicit). explicit needs reserved huge pages, otherwise falls back to thp\n" );
          exit(0);
       break;
       default:
@@ -102,19 +514,40 @@ int main(int argc, char *argv[])
       }
    }
 
-   if(config.filePath != "" && config.sampleRate > 0 && config.fftSize > 0 && config.timeBetweenFfts > 0 && outPath != "")
+   tGetJobsFunc getJobs = [&]{return getHeatMapJobs(config.filePath, listPath, outPath, output.renderFromCache);};
+   std::vector<tHeatMapJob> jobs = getJobs();
+   bool validFftSettings = config.sampleRate > 0 && config.fftSize > 0 && config.timeBetweenFfts > 0;
+   if(output.incremental && output.saveDbCache)
    {
-           if(inputFormat == "int8_t")   {GenHeatMap<int8_t>  (config, outPath, maxFileSize);}
-      else if(inputFormat == "int16_t")  {GenHeatMap<int16_t> (config, outPath, maxFileSize);}
-      else if(inputFormat == "int32_t")  {GenHeatMap<int32_t> (config, outPath, maxFileSize);}
-      else if(inputFormat == "int64_t")  {GenHeatMap<int64_t> (config, outPath, maxFileSize);}
-      else if(inputFormat == "uint8_t")  {GenHeatMap<uint8_t> (config, outPath, maxFileSize);}
-      else if(inputFormat == "uint16_t") {GenHeatMap<uint16_t>(config, outPath, maxFileSize);}
-      else if(inputFormat == "uint32_t") {GenHeatMap<uint32_t>(config, outPath, maxFileSize);}
-      else if(inputFormat == "uint64_t") {GenHeatMap<uint64_t>(config, outPath, maxFileSize);}
-      else if(inputFormat == "float")    {GenHeatMap<float>   (config, outPath, maxFileSize);}
-      else if(inputFormat == "double")   {GenHeatMap<double>  (config, outPath, maxFileSize);}
+      // Incremental mode never has all the dB values in memory (see genHeatMapPngSplit).
+      printf("Can't save a dB cache (-K) in incremental mode (-I / -F)\n");
+   }
+   else if(jobs.size() > 0 && (validFftSettings || output.renderFromCache))
+   {
+      if(wisdomPath != "")
+         loadFftWisdom(wisdomPath); // It's fine if this fails, the file won't exist the first time.
+      if(profileSummaryPath != "" || profileTracePath != "")
+         config.profiler = std::make_shared<Profiler>(profileTracePath != "");
+
+           if(output.renderFromCache)    {RenderDbCaches(config, jobs, output);}
+      else if(inputFormat == "int8_t")   {GenHeatMaps<int8_t>  (config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "int16_t")  {GenHeatMaps<int16_t> (config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "int32_t")  {GenHeatMaps<int32_t> (config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "int64_t")  {GenHeatMaps<int64_t> (config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "uint8_t")  {GenHeatMaps<uint8_t> (config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "uint16_t") {GenHeatMaps<uint16_t>(config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "uint32_t") {GenHeatMaps<uint32_t>(config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "uint64_t") {GenHeatMaps<uint64_t>(config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "float")    {GenHeatMaps<float>   (config, jobs, getJobs, output, singlePrecision, streamConfig);}
+      else if(inputFormat == "double")   {GenHeatMaps<double>  (config, jobs, getJobs, output, singlePrecision, streamConfig);}
       else{printf("Invalid Input Format\n");}
+
+      if(wisdomPath != "")
+         saveFftWisdom(wisdomPath);
+      if(profileSummaryPath != "" && !config.profiler->saveSummary(profileSummaryPath))
+         printf("Failed to save %s\n", profileSummaryPath.c_str());
+      if(profileTracePath != "" && !config.profiler->saveTrace(profileTracePath))
+         printf("Failed to save %s\n", profileTracePath.c_str());
    }
    else
    {
@@ -0,0 +1,172 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "SignalGen.h"
+
+// Number of IQ samples generated / written at a time.
+static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+template<typename tSampType>
+bool WriteCapture(SignalGen& signalGen, const std::string& outPath, uint64_t numSamples)
+{
+   std::ofstream outFile(outPath, std::ios::binary);
+   if(!outFile.is_open())
+      return false;
+
+   std::vector<double> iq(2*BLOCK_SIZE);
+   std::vector<tSampType> samples(2*BLOCK_SIZE);
+   for(uint64_t sampIndex = 0; sampIndex < numSamples && outFile.good(); sampIndex += BLOCK_SIZE)
+   {
+      size_t numInBlock = size_t(std::min(uint64_t(BLOCK_SIZE), numSamples - sampIndex));
+      signalGen.generate(iq.data(), numInBlock);
+      convertFromDouble(iq.data(), samples.data(), 2*numInBlock);
+      outFile.write(reinterpret_cast<const char*>(samples.data()), 2*sizeof(tSampType)*numInBlock);
+   }
+   return outFile.good();
+}
+
+// Parses comma separated values, e.g. "1000,0.5".
+static std::vector<double> ParseValues(const char* str)
+{
+   std::vector<double> values;
+   char* end = nullptr;
+   while(*str != '\0')
+   {
+      values.push_back(strtod(str, &end));
+      if(end == str)
+         break;
+      str = (*end == ',') ? end + 1 : end;
+   }
+   return values;
+}
+
+int main(int argc, char *argv[])
+{
+   std::string outPath;
+   std::string outputFormat = "int16_t";
+   double sampleRate = 0;
+   double numSeconds = 0;
+   uint64_t numSamples = 0;
+   uint32_t seed = 1;
+   std::vector<std::vector<double>> tones, chirps, bursts;
+   double noise = 0;
+
+   const char* argStr = "o:y:s:d:n:T:c:b:r:e:h";
+   int option = -1;
+   while((option = getopt(argc, argv, argStr)) != -1)
+   {
+      switch(option)
+      {
+      case 'o':
+         outPath = std::string(optarg);
+      break;
+      case 'y':
+         outputFormat = std::string(optarg);
+      break;
+      case 's':
+         sampleRate = strtod(optarg, nullptr);
+      break;
+      case 'd':
+         numSeconds = strtod(optarg, nullptr);
+      break;
+      case 'n':
+         numSamples = strtoull(optarg, nullptr, 10);
+      break;
+      case 'T':
+         tones.push_back(ParseValues(optarg));
+      break;
+      case 'c':
+         chirps.push_back(ParseValues(optarg));
+      break;
+      case 'b':
+         bursts.push_back(ParseValues(optarg));
+      break;
+      case 'r':
+         noise = strtod(optarg, nullptr);
+      break;
+      case 'e':
+         seed = strtoul(optarg, nullptr, 10);
+      break;
+      case 'h':
+         printf("Help:\n -o : output file\n -y : Output Format (float, double, int16_t, etc)\n -s : sample rate\n"
+             " -d : Duration in seconds\n -n : Number of IQ samples (instead of -d)\n"
+             " -T : Tone 'freq,amplitude' (can be repeated)\n"
+             " -c : Chirp 'startFreq,stopFreq,sweepSeconds,amplitude' (can be repeated)\n"
+             " -b : Burst 'freq,amplitude,onSeconds,periodSeconds' (can be repeated)\n"
+             " -r : Noise amplitude\n -e : Noise seed\n"
+             " Amplitudes are relative to full scale (1.0), frequencies are in Hz.\n" );
+         exit(0);
+      break;
+      default:
+         // invalid arg
+      break;
+      }
+   }
+
+   if(numSamples == 0)
+      numSamples = uint64_t(numSeconds * sampleRate + 0.5);
+   if(outPath == "" || sampleRate <= 0 || numSamples == 0)
+   {
+      printf("Invalid input config\n");
+      return 1;
+   }
+
+   SignalGen signalGen(sampleRate, seed);
+   for(auto& tone : tones)
+   {
+      if(tone.size() >= 2)
+         signalGen.addTone(tone[0], tone[1]);
+   }
+   for(auto& chirp : chirps)
+   {
+      if(chirp.size() >= 4)
+         signalGen.addChirp(chirp[0], chirp[1], chirp[2], chirp[3]);
+   }
+   for(auto& burst : bursts)
+   {
+      if(burst.size() >= 4)
+         signalGen.addBurst(burst[0], burst[1], burst[2], burst[3]);
+   }
+   signalGen.setNoise(noise);
+
+   bool success = false;
+        if(outputFormat == "int8_t")   {success = WriteCapture<int8_t>  (signalGen, outPath, numSamples);}
+   else if(outputFormat == "int16_t")  {success = WriteCapture<int16_t> (signalGen, outPath, numSamples);}
+   else if(outputFormat == "int32_t")  {success = WriteCapture<int32_t> (signalGen, outPath, numSamples);}
+   else if(outputFormat == "int64_t")  {success = WriteCapture<int64_t> (signalGen, outPath, numSamples);}
+   else if(outputFormat == "uint8_t")  {success = WriteCapture<uint8_t> (signalGen, outPath, numSamples);}
+   else if(outputFormat == "uint16_t") {success = WriteCapture<uint16_t>(signalGen, outPath, numSamples);}
+   else if(outputFormat == "uint32_t") {success = WriteCapture<uint32_t>(signalGen, outPath, numSamples);}
+   else if(outputFormat == "uint64_t") {success = WriteCapture<uint64_t>(signalGen, outPath, numSamples);}
+   else if(outputFormat == "float")    {success = WriteCapture<float>   (signalGen, outPath, numSamples);}
+   else if(outputFormat == "double")   {success = WriteCapture<double>  (signalGen, outPath, numSamples);}
+   else{printf("Invalid Output Format\n"); return 1;}
+
+   if(!success)
+   {
+      printf("Failed to write %s\n", outPath.c_str());
+      return 1;
+   }
+   return 0;
+}
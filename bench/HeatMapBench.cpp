@@ -0,0 +1,362 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FileToHeatMap.h"
+#include "Profiler.h"
+#include "SignalGen.h"
+#include "fftHelper.h"
+#include "fftKernels.h"
+
+// Benchmarks each stage of the heat map pipeline on its own (for a range of FFT sizes), then the
+// whole pipeline for a range of thread counts. Throughput is reported in millions of IQ samples
+// per second, so the stages can be compared against each other.
+
+typedef struct tBenchConfig
+{
+   size_t minFftSize = 64;
+   size_t maxFftSize = 1 << 20;
+   size_t fftSizeStep = 4; // Multiply the FFT size by this for each step.
+   size_t e2eFftSize = 2048;
+   size_t maxThreads = std::thread::hardware_concurrency();
+   size_t numSamples = 1 << 24; // Samples in the capture used by the file / end to end benchmarks.
+   double minSeconds = 0.25; // Minimum time spent on each measurement.
+   std::string tempDir = "/tmp";
+} tBenchConfig;
+
+static tBenchConfig g_config;
+
+// Number of IQ samples processed per call by the single stage benchmarks.
+static constexpr size_t SAMPLES_PER_CALL = 1 << 20;
+
+// Runs 'func' until at least 'minSeconds' have passed. Returns the average seconds per call.
+template<typename tFunc>
+static double TimeIt(tFunc func)
+{
+   auto start = std::chrono::steady_clock::now();
+   size_t numCalls = 0;
+   double elapsed = 0;
+   do
+   {
+      func();
+      ++numCalls;
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }while(elapsed < g_config.minSeconds);
+   return elapsed / numCalls;
+}
+
+static void Report(const std::string& stage, const std::string& type, size_t fftSize, size_t numThreads, size_t numSamples, double seconds)
+{
+   printf("%-24s %-10s %8zu %4zu %10.2f MSamp/s\n", stage.c_str(), type.c_str(), fftSize, numThreads, numSamples / seconds / 1e6);
+   fflush(stdout);
+}
+
+template<typename tType> static const char* TypeName();
+template<> const char* TypeName<int8_t>()  {return "int8_t";}
+template<> const char* TypeName<int16_t>() {return "int16_t";}
+template<> const char* TypeName<int32_t>() {return "int32_t";}
+template<> const char* TypeName<int64_t>() {return "int64_t";}
+template<> const char* TypeName<uint8_t>() {return "uint8_t";}
+template<> const char* TypeName<uint16_t>(){return "uint16_t";}
+template<> const char* TypeName<uint32_t>(){return "uint32_t";}
+template<> const char* TypeName<uint64_t>(){return "uint64_t";}
+template<> const char* TypeName<float>()   {return "float";}
+template<> const char* TypeName<double>()  {return "double";}
+
+// Writes a test capture, a few tones and a chirp over noise.
+template<typename tSampType>
+static bool WriteCapture(const std::string& path, size_t numSamples)
+{
+   constexpr size_t BLOCK_SIZE = 1 << 20;
+   SignalGen signalGen(1e6);
+   signalGen.addTone(-250e3, 0.1);
+   signalGen.addTone(100e3, 0.01);
+   signalGen.addChirp(-400e3, 400e3, 0.5, 0.05);
+   signalGen.setNoise(0.001);
+
+   std::ofstream outFile(path, std::ios::binary);
+   std::vector<double> iq(2*BLOCK_SIZE);
+   std::vector<tSampType> samples(2*BLOCK_SIZE);
+   for(size_t sampIndex = 0; sampIndex < numSamples && outFile.good(); sampIndex += BLOCK_SIZE)
+   {
+      size_t numInBlock = std::min(BLOCK_SIZE, numSamples - sampIndex);
+      signalGen.generate(iq.data(), numInBlock);
+      convertFromDouble(iq.data(), samples.data(), 2*numInBlock);
+      outFile.write(reinterpret_cast<const char*>(samples.data()), 2*sizeof(tSampType)*numInBlock);
+   }
+   return outFile.good();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Single stage benchmarks
+////////////////////////////////////////////////////////////////////////////////
+
+// Times FileToHeatMap::readFromFile, i.e. the read stage of genHeatMap on a single thread (from
+// the profiler). Memory mapped reads only point at the samples, the FFT stage takes the page faults.
+template<typename tSampType>
+static void BenchRead(const std::string& path, size_t fftSize, bool memoryMapInput)
+{
+   tFileToHeatMapConfig config;
+   config.filePath = path;
+   config.fftSize = fftSize;
+   config.timeBetweenFfts = 1.0 / config.sampleRate * fftSize;
+   config.memoryMapInput = memoryMapInput;
+   config.profiler = std::make_shared<Profiler>(false);
+   FileToHeatMap<tSampType, float> heatMap(config);
+   TimeIt([&](){heatMap.genHeatMap();});
+   Profiler::tStageStats read = config.profiler->getStageTotals(Profiler::E_STAGE_READ);
+   if(read.wallNs > 0)
+      Report(memoryMapInput ? "readFromFile_mmap" : "readFromFile", TypeName<tSampType>(), fftSize, 1, read.numItems*fftSize, read.wallNs * 1e-9);
+}
+
+template<typename tSampType, typename tFftType>
+static void BenchConvert(size_t fftSize)
+{
+   size_t numFfts = std::max(size_t(1), SAMPLES_PER_CALL / fftSize);
+   std::vector<tSampType> samples(2*fftSize*numFfts);
+   std::vector<double> iq(samples.size());
+   SignalGen signalGen(1e6);
+   signalGen.addTone(1e3, 0.5);
+   signalGen.generate(iq.data(), fftSize*numFfts);
+   convertFromDouble(iq.data(), samples.data(), samples.size());
+
+   std::vector<double> windowCoef(fftSize);
+   genFftShiftWindowCoef(windowCoef.data(), fftSize);
+   std::vector<tFftType> window(2*fftSize);
+   for(size_t i = 0; i < fftSize; ++i)
+      window[2*i] = window[2*i+1] = tFftType(windowCoef[i]);
+   std::vector<tFftType> fftIn(2*fftSize);
+
+   double seconds = TimeIt([&]()
+   {
+      for(size_t i = 0; i < numFfts; ++i)
+         convertAndWindow(&samples[2*fftSize*i], window.data(), fftIn.data(), 2*fftSize);
+   });
+   Report(std::string("convertAndWindow_") + TypeName<tFftType>(), TypeName<tSampType>(), fftSize, 1, numFfts*fftSize, seconds);
+}
+
+template<typename tFftType>
+static void BenchFft(size_t fftSize)
+{
+   size_t numFfts = std::max(size_t(1), SAMPLES_PER_CALL / fftSize);
+   ComplexFftBatch<tFftType>& fftBatch = ComplexFftBatch<tFftType>::get(fftSize, numFfts);
+   tFftType* fftIn = fftBatch.getInput();
+   for(size_t i = 0; i < 2*fftSize*numFfts; ++i)
+      fftIn[i] = tFftType(sin(double(i)));
+   double seconds = TimeIt([&](){fftBatch.execute();});
+   Report("ComplexFftBatch", TypeName<tFftType>(), fftSize, 1, numFfts*fftSize, seconds);
+}
+
+static void BenchComplexFft(size_t fftSize)
+{
+   dubVect re, im, outRe, outIm;
+   makeComplexSineWave(1e6, 1e3, fftSize, re, im);
+   double seconds = TimeIt([&](){complexFFT(re, im, outRe, outIm);});
+   Report("complexFFT", "double", fftSize, 1, fftSize, seconds);
+}
+
+template<typename tFftType>
+static void BenchPowerToDb(size_t fftSize)
+{
+   size_t numFfts = std::max(size_t(1), SAMPLES_PER_CALL / fftSize);
+   std::vector<tFftType> fftOut(2*fftSize);
+   for(size_t i = 0; i < fftOut.size(); ++i)
+      fftOut[i] = tFftType(sin(double(i)));
+   std::vector<tFftType> dB(fftSize);
+   double seconds = TimeIt([&]()
+   {
+      for(size_t i = 0; i < numFfts; ++i)
+      {
+         tFftType minDb = std::numeric_limits<tFftType>::infinity();
+         tFftType maxDb = -std::numeric_limits<tFftType>::infinity();
+         powerToDb(fftOut.data(), dB.data(), fftSize, tFftType(0), minDb, maxDb);
+      }
+   });
+   Report("powerToDb", TypeName<tFftType>(), fftSize, 1, numFfts*fftSize, seconds);
+}
+
+// Renders / saves a heat map made from the capture. Throughput is in heat map pixels (i.e. dB values).
+// With 'storeDb' the heat map keeps the dB values instead of color levels, so rendering also maps
+// dB to levels (the path normalized / auto scaled heat maps and dB caches take).
+static void BenchRender(const std::string& path, size_t fftSize, bool storeDb)
+{
+   tFileToHeatMapConfig config;
+   config.filePath = path;
+   config.fftSize = fftSize;
+   config.timeBetweenFfts = 1.0 / config.sampleRate * fftSize;
+   config.numThreads = g_config.maxThreads;
+   config.storeDb = storeDb;
+   FileToHeatMap<int16_t, float> heatMap(config);
+   heatMap.genHeatMap();
+   size_t numPixels = heatMap.getNumFfts() * heatMap.getNumBins();
+   if(numPixels == 0)
+      return;
+
+   std::string savePath = g_config.tempDir + "/HeatMapBench";
+   std::string suffix = storeDb ? "_dB" : "";
+   Report("fftToRgb" + suffix, "float", fftSize, config.numThreads, numPixels, TimeIt([&](){heatMap.fftToRgb(false);}));
+   Report("fftToRgb_rotate" + suffix, "float", fftSize, config.numThreads, numPixels, TimeIt([&](){heatMap.fftToRgb(true);}));
+   Report("savePng" + suffix, "float", fftSize, config.numThreads, numPixels, TimeIt([&](){heatMap.savePng(savePath + ".png");}));
+   Report("saveBmp" + suffix, "float", fftSize, config.numThreads, numPixels, TimeIt([&](){heatMap.saveBmp(savePath + ".bmp");}));
+   remove((savePath + ".png").c_str());
+   remove((savePath + ".bmp").c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// End to end benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename tSampType, typename tFftType>
+static void BenchGenHeatMap(const std::string& path, size_t numThreads, bool memoryMapInput)
+{
+   tFileToHeatMapConfig config;
+   config.filePath = path;
+   config.fftSize = g_config.e2eFftSize;
+   config.timeBetweenFfts = 1.0 / config.sampleRate * config.fftSize;
+   config.numThreads = numThreads;
+   config.memoryMapInput = memoryMapInput;
+   FileToHeatMap<tSampType, tFftType> heatMap(config);
+   double seconds = TimeIt([&](){heatMap.genHeatMap();});
+   std::string stage = std::string(memoryMapInput ? "genHeatMap_mmap_" : "genHeatMap_") + TypeName<tFftType>();
+   Report(stage, TypeName<tSampType>(), config.fftSize, numThreads, g_config.numSamples, seconds);
+}
+
+template<typename tSampType>
+static void BenchSampType()
+{
+   std::string path = g_config.tempDir + "/HeatMapBench_" + TypeName<tSampType>() + ".bin";
+   if(!WriteCapture<tSampType>(path, g_config.numSamples))
+   {
+      printf("Failed to write %s\n", path.c_str());
+      return;
+   }
+   BenchRead<tSampType>(path, g_config.e2eFftSize, false);
+   BenchRead<tSampType>(path, g_config.e2eFftSize, true);
+   for(size_t numThreads = 1; numThreads <= g_config.maxThreads; numThreads *= 2)
+   {
+      BenchGenHeatMap<tSampType, float>(path, numThreads, false);
+      BenchGenHeatMap<tSampType, float>(path, numThreads, true);
+      BenchGenHeatMap<tSampType, double>(path, numThreads, true);
+   }
+   remove(path.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+   const char* argStr = "m:M:x:f:t:n:s:d:h";
+   int option = -1;
+   while((option = getopt(argc, argv, argStr)) != -1)
+   {
+      switch(option)
+      {
+      case 'm':
+         g_config.minFftSize = strtoull(optarg, nullptr, 10);
+      break;
+      case 'M':
+         g_config.maxFftSize = strtoull(optarg, nullptr, 10);
+      break;
+      case 'x':
+         g_config.fftSizeStep = strtoull(optarg, nullptr, 10);
+      break;
+      case 'f':
+         g_config.e2eFftSize = strtoull(optarg, nullptr, 10);
+      break;
+      case 't':
+         g_config.maxThreads = strtoull(optarg, nullptr, 10);
+      break;
+      case 'n':
+         g_config.numSamples = strtoull(optarg, nullptr, 10);
+      break;
+      case 's':
+         g_config.minSeconds = strtod(optarg, nullptr);
+      break;
+      case 'd':
+         g_config.tempDir = std::string(optarg);
+      break;
+      case 'h':
+         printf("Help:\n -m : Min FFT Size (default 64)\n -M : Max FFT Size (default 1048576)\n"
+             " -x : FFT Size step multiplier (default 4)\n -f : FFT Size for the end to end benchmark (default 2048)\n"
+             " -t : Max number of threads (default all cores)\n -n : Number of IQ samples in the test captures (default 16M)\n"
+             " -s : Min seconds per measurement (default 0.25)\n -d : Directory for the temporary test files (default /tmp)\n" );
+         exit(0);
+      break;
+      default:
+         // invalid arg
+      break;
+      }
+   }
+   if(g_config.minFftSize < 1 || g_config.fftSizeStep < 2 || g_config.maxThreads < 1 || g_config.numSamples < g_config.maxFftSize)
+   {
+      printf("Invalid input config\n");
+      return 1;
+   }
+
+   printf("%-24s %-10s %8s %4s %10s\n", "Stage", "Type", "FFT Size", "Thr", "Throughput");
+
+   std::string capturePath = g_config.tempDir + "/HeatMapBench_int16_t.bin";
+   if(!WriteCapture<int16_t>(capturePath, g_config.numSamples))
+   {
+      printf("Failed to write %s\n", capturePath.c_str());
+      return 1;
+   }
+   for(size_t fftSize = g_config.minFftSize; fftSize <= g_config.maxFftSize; fftSize *= g_config.fftSizeStep)
+   {
+      BenchRead<int16_t>(capturePath, fftSize, false);
+      BenchRead<int16_t>(capturePath, fftSize, true);
+      BenchConvert<int8_t,   float>(fftSize);
+      BenchConvert<int16_t,  float>(fftSize);
+      BenchConvert<int32_t,  float>(fftSize);
+      BenchConvert<int64_t,  float>(fftSize);
+      BenchConvert<uint8_t,  float>(fftSize);
+      BenchConvert<uint16_t, float>(fftSize);
+      BenchConvert<uint32_t, float>(fftSize);
+      BenchConvert<uint64_t, float>(fftSize);
+      BenchConvert<float,    float>(fftSize);
+      BenchConvert<double,   float>(fftSize);
+      BenchConvert<int16_t,  double>(fftSize);
+      BenchConvert<float,    double>(fftSize);
+      BenchFft<float>(fftSize);
+      BenchFft<double>(fftSize);
+      BenchComplexFft(fftSize);
+      BenchPowerToDb<float>(fftSize);
+      BenchPowerToDb<double>(fftSize);
+      BenchRender(capturePath, fftSize, false);
+      BenchRender(capturePath, fftSize, true);
+   }
+   remove(capturePath.c_str());
+
+   BenchSampType<int8_t>();
+   BenchSampType<int16_t>();
+   BenchSampType<int32_t>();
+   BenchSampType<int64_t>();
+   BenchSampType<uint8_t>();
+   BenchSampType<uint16_t>();
+   BenchSampType<uint32_t>();
+   BenchSampType<uint64_t>();
+   BenchSampType<float>();
+   BenchSampType<double>();
+   return 0;
+}
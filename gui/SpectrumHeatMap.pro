@@ -22,6 +22,7 @@ SOURCES += \
     hsvrgb.cpp \
     main.cpp \
     mainwindow.cpp \
+    SignalGen.cpp \
     plotperfectclient/sendMemoryToPlot.cpp \
     plotperfectclient/smartPlotMessage.cpp
 
@@ -29,7 +30,8 @@ HEADERS += \
     FileToHeatMap.h \
     fftHelper.h \
     hsvrgb.h \
-    mainwindow.h
+    mainwindow.h \
+    SignalGen.h
 
 FORMS += \
     mainwindow.ui
@@ -40,9 +42,9 @@ INCLUDEPATH += $$FFTWDIR
 
 win32 {
     LIBS += -lws2_32
-    LIBS += -L$$FFTWDIR/$$ARCHDIR -lfftw3-3
+    LIBS += -L$$FFTWDIR/$$ARCHDIR -lfftw3-3 -lfftw3f-3
 } else {
-    LIBS += -L$$FFTWDIR/$$ARCHDIR -lfftw3
+    LIBS += -L$$FFTWDIR/$$ARCHDIR -lfftw3 -lfftw3f
 }
 
 # Default rules for deployment.
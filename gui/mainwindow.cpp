@@ -10,38 +10,10 @@
 
 #include "fftHelper.h"
 #include "hsvrgb.h"
-#include <random>
+#include "SignalGen.h"
 
 #include "smartPlotMessage.h"
 
-std::default_random_engine generator;
-
-void makeComplexSineWave(double sampRate, double waveFreq, size_t numSamp, dubVect& re, dubVect& im)
-{
-   re.resize(numSamp);
-   im.resize(numSamp);
-   double phaseIncr = 2.0 * M_PI * waveFreq / sampRate;
-   double phase = 0;
-   for(size_t i = 0; i < numSamp; ++i)
-   {
-      re[i] = cos(phase);
-      im[i] = sin(phase);
-      phase += phaseIncr;
-   }
-}
-
-void addRandom(dubVect& re, dubVect& im)
-{
-   double randVal = 0.08;
-   std::uniform_real_distribution<double> distribution(-randVal, randVal);
-   size_t numSamp = std::min(re.size(), im.size());
-   for(size_t i = 0; i < numSamp; ++i)
-   {
-      re[i] += distribution(generator);
-      im[i] += distribution(generator);
-   }
-}
-
 void complexPowerFFT(dubVect& re, dubVect& im, dubVect& out)
 {
    size_t numSamp = std::min(re.size(), im.size());
@@ -0,0 +1,100 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <limits>
+#include <vector>
+#include "fftKernels.h"
+
+// Checks that the dB kernels handle the special floating point values like std::log2 does: NaN and
+// inf pass through, 0 gives -inf, and NaN doesn't end up in the min / max. The special values are put
+// both in the SIMD part of the buffer and in the left over samples (handled by the plain C++ code).
+
+static int g_numFailures = 0;
+
+static void check(bool pass, const char* typeName, const char* kernel, const char* what, size_t index)
+{
+   if(!pass)
+   {
+      fprintf(stderr, "FAIL: %s %s %s (index %zu)\n", typeName, kernel, what, index);
+      ++g_numFailures;
+   }
+}
+
+template<typename tFftType>
+static void checkDb(const char* typeName, const char* kernel, const std::vector<tFftType>& power, const std::vector<tFftType>& dB, tFftType minDb, tFftType maxDb)
+{
+   for(size_t i = 0; i < power.size(); ++i)
+   {
+      if(std::isnan(power[i]))
+         check(std::isnan(dB[i]), typeName, kernel, "NaN -> NaN", i);
+      else if(std::isinf(power[i]))
+         check(std::isinf(dB[i]) && dB[i] > 0, typeName, kernel, "inf -> inf", i);
+      else if(power[i] == tFftType(0))
+         check(std::isinf(dB[i]) && dB[i] < 0, typeName, kernel, "0 -> -inf", i);
+      else
+         check(fabs(double(dB[i]) - 10.0*log10(double(power[i]))) < 1e-3, typeName, kernel, "dB value", i);
+   }
+   check(!std::isnan(minDb) && std::isinf(minDb) && minDb < 0, typeName, kernel, "min ignores NaN", 0);
+   check(!std::isnan(maxDb) && std::isinf(maxDb) && maxDb > 0, typeName, kernel, "max ignores NaN", 0);
+}
+
+template<typename tFftType>
+static void testType(const char* typeName)
+{
+   const tFftType nan = std::numeric_limits<tFftType>::quiet_NaN();
+   const tFftType inf = std::numeric_limits<tFftType>::infinity();
+
+   // 19 values: the SIMD loops handle the first 16, the plain C++ code handles the last 3.
+   std::vector<tFftType> power = {1, nan, 2, 0, 0.5, inf, 1e-6, 3, 1e6, 7, nan, 0, 0.25, 10, inf, 4, nan, 0, inf};
+   std::vector<tFftType> dB(power.size());
+
+   // linearToDb takes the power directly.
+   tFftType minDb = std::numeric_limits<tFftType>::infinity();
+   tFftType maxDb = -std::numeric_limits<tFftType>::infinity();
+   linearToDb(power.data(), dB.data(), power.size(), tFftType(0), minDb, maxDb);
+   checkDb(typeName, "linearToDb", power, dB, minDb, maxDb);
+
+   // powerToDb takes complex FFT output, re^2 + im^2 is the power (im = 0, re = sqrt(power)).
+   std::vector<tFftType> fftOut(2*power.size(), 0);
+   for(size_t i = 0; i < power.size(); ++i)
+      fftOut[2*i] = std::isnan(power[i]) ? nan : tFftType(sqrt(double(power[i])));
+   minDb = std::numeric_limits<tFftType>::infinity();
+   maxDb = -std::numeric_limits<tFftType>::infinity();
+   powerToDb(fftOut.data(), dB.data(), power.size(), tFftType(0), minDb, maxDb);
+   checkDb(typeName, "powerToDb", power, dB, minDb, maxDb);
+
+   // NaN maps to a valid color level (the lowest).
+   uint8_t level = 0;
+   dbToLevel(&nan, &level, 1, -100.0, 100.0);
+   check(level == 255, typeName, "dbToLevel", "NaN -> lowest level", 0);
+}
+
+int main(int argc, char *argv[])
+{
+   testType<double>("double");
+   testType<float>("float");
+   if(g_numFailures > 0)
+   {
+      fprintf(stderr, "%d failures\n", g_numFailures);
+      return 1;
+   }
+   printf("All tests passed\n");
+   return 0;
+}
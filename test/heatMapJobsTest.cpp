@@ -0,0 +1,137 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "HeatMapJobs.h"
+
+// Checks the jobs found for an input directory, in particular that running again over the same
+// directory (e.g. a nightly rerun) doesn't pick up the outputs of the previous run as captures.
+
+namespace fs = std::filesystem;
+
+static int g_numFailures = 0;
+
+static void check(bool pass, const char* test, const std::string& what)
+{
+   if(!pass)
+   {
+      fprintf(stderr, "FAIL: %s %s\n", test, what.c_str());
+      ++g_numFailures;
+   }
+}
+
+static void touch(const fs::path& path)
+{
+   fs::create_directories(path.parent_path());
+   std::ofstream(path) << "x";
+}
+
+// Checks the jobs are exactly 'expected' (input path relative to 'root' -> output path).
+static void checkJobs(const char* test, const std::vector<tHeatMapJob>& jobs, const fs::path& root, const std::vector<std::pair<std::string, std::string>>& expected)
+{
+   check(jobs.size() == expected.size(), test, "number of jobs " + std::to_string(jobs.size()) + " expected " + std::to_string(expected.size()));
+   for(size_t i = 0; i < std::min(jobs.size(), expected.size()); ++i)
+   {
+      check(jobs[i].inPath == (root / expected[i].first).string(), test, "input " + jobs[i].inPath);
+      check(jobs[i].outPath == expected[i].second, test, "output " + jobs[i].outPath);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   fs::path root = fs::temp_directory_path() / ("heatMapJobsTest_" + std::to_string(getpid()));
+   fs::path in = root / "in";
+   fs::remove_all(root);
+   touch(in / "a.bin");
+   touch(in / "day1" / "cap.bin");
+   touch(in / "day2" / "cap.bin");
+
+   // Outputs next to the inputs (no output directory). The 2nd run must find the same inputs even
+   // though the 1st run wrote its images, dB caches and state files next to them.
+   std::vector<std::pair<std::string, std::string>> nextToInputs = {
+      {"a.bin", (in / "a.bin").string()}, {"day1/cap.bin", (in / "day1" / "cap.bin").string()}, {"day2/cap.bin", (in / "day2" / "cap.bin").string()}};
+   auto jobs = getHeatMapJobs(in.string(), "", "");
+   checkJobs("next to inputs, 1st run", jobs, in, nextToInputs);
+   for(auto& job : jobs)
+   {
+      touch(job.outPath + ".png");
+      touch(job.outPath + "_0.png");
+      touch(job.outPath + ".dbcache");
+      touch(job.outPath + ".state");
+      touch(job.outPath + ".state.tmp");
+   }
+   checkJobs("next to inputs, 2nd run", getHeatMapJobs(in.string(), "", ""), in, nextToInputs);
+
+   // Output directory outside of the input. Inputs with the same name in different sub directories
+   // get different outputs.
+   fs::path out = root / "out";
+   std::vector<std::pair<std::string, std::string>> outside = {
+      {"a.bin", (out / "a.bin").string()}, {"day1/cap.bin", (out / "day1" / "cap.bin").string()}, {"day2/cap.bin", (out / "day2" / "cap.bin").string()}};
+   checkJobs("output directory", getHeatMapJobs(in.string(), "", out.string()), in, outside);
+   check(fs::is_directory(out / "day1") && fs::is_directory(out / "day2"), "output directory", "sub directories created");
+
+   // Output directory inside the input. Nothing in it is an input, whatever its extension.
+   fs::path inside = in / "heatmaps";
+   touch(inside / "a.bin");
+   std::vector<std::pair<std::string, std::string>> insideExpected = {
+      {"a.bin", (inside / "a.bin").string()}, {"day1/cap.bin", (inside / "day1" / "cap.bin").string()}, {"day2/cap.bin", (inside / "day2" / "cap.bin").string()}};
+   checkJobs("output directory inside the input", getHeatMapJobs(in.string(), "", inside.string()), in, insideExpected);
+
+   // Following a directory. Every pass finds the jobs again, new captures are picked up and the
+   // incremental outputs (split images, state files) written by earlier passes never are.
+   fs::path follow = root / "follow";
+   touch(follow / "a.bin");
+   std::vector<std::pair<std::string, std::string>> followExpected = {{"a.bin", (follow / "a.bin").string()}};
+   for(size_t pass = 0; pass < 2; ++pass)
+   {
+      auto followJobs = getHeatMapJobs(follow.string(), "", "");
+      checkJobs(pass == 0 ? "follow, 1st pass" : "follow, 2nd pass", followJobs, follow, followExpected);
+      for(auto& job : followJobs)
+      {
+         touch(job.outPath + "_0.png");
+         touch(job.outPath + "_1.png");
+         touch(job.outPath + ".state");
+         touch(job.outPath + ".state.tmp");
+      }
+      if(pass == 0)
+      {
+         touch(follow / "b.bin"); // New capture, shows up in the next pass.
+         followExpected.push_back({"b.bin", (follow / "b.bin").string()});
+      }
+   }
+
+   // Render only, the inputs are the dB caches.
+   std::vector<std::pair<std::string, std::string>> dbCaches = {
+      {"a.bin.dbcache", (in / "a.bin.dbcache").string()}, {"day1/cap.bin.dbcache", (in / "day1" / "cap.bin.dbcache").string()},
+      {"day2/cap.bin.dbcache", (in / "day2" / "cap.bin.dbcache").string()}};
+   checkJobs("dB caches", getHeatMapJobs(in.string(), "", "", true), in, dbCaches);
+
+   fs::remove_all(root);
+   if(g_numFailures > 0)
+   {
+      fprintf(stderr, "%d failures\n", g_numFailures);
+      return 1;
+   }
+   printf("All tests passed\n");
+   return 0;
+}
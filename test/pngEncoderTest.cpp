@@ -0,0 +1,150 @@
+/* Copyright 2026 Dan Williams. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+ * to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "lodepng.h"
+#include "PngEncoder.h"
+
+// Encodes images with the PNG encoder (fast and slow mode, in one go and streamed) and decodes them
+// with lodepng to check they decode to the same pixels.
+
+namespace fs = std::filesystem;
+
+static int g_numFailures = 0;
+
+static void check(bool pass, const std::string& test, const std::string& what)
+{
+   if(!pass)
+   {
+      fprintf(stderr, "FAIL: %s %s\n", test.c_str(), what.c_str());
+      ++g_numFailures;
+   }
+}
+
+// Noise with runs of the same color and rows that repeat further back, like a heat map has. That
+// gives the encoder literals, run matches and matches found by the hash chains.
+static std::vector<uint8_t> makeImage(size_t width, size_t height, unsigned seed)
+{
+   std::mt19937 rng(seed);
+   std::vector<uint8_t> rgb(3*width*height);
+   for(size_t y = 0; y < height; ++y)
+   {
+      uint8_t* row = &rgb[3*width*y];
+      if(y >= 5 && rng() % 4 == 0)
+      {
+         memcpy(row, row - 5*3*width, 3*width); // Same as a row further up.
+         continue;
+      }
+      for(size_t x = 0; x < width;)
+      {
+         size_t run = rng() % 3 == 0 ? 1 + rng() % 40 : 1;
+         uint8_t color[3] = {uint8_t(rng() % 8), uint8_t(rng()), uint8_t(rng() % 3 * 100)};
+         for(; run > 0 && x < width; --run, ++x)
+            memcpy(&row[3*x], color, 3);
+      }
+   }
+   return rgb;
+}
+
+// Decodes 'path' and checks it is 'width' x 'height' and the first 'numRows' rows are 'rgb' (the
+// rest must be black).
+static void checkDecode(const std::string& test, const std::string& path, const std::vector<uint8_t>& rgb, size_t width, size_t height, size_t numRows)
+{
+   std::vector<unsigned char> decoded;
+   unsigned decodedWidth = 0;
+   unsigned decodedHeight = 0;
+   unsigned error = lodepng::decode(decoded, decodedWidth, decodedHeight, path, LCT_RGB, 8);
+   check(error == 0, test, "decode error " + std::to_string(error));
+   if(error != 0)
+      return;
+   check(decodedWidth == width && decodedHeight == height, test, "size " + std::to_string(decodedWidth) + "x" + std::to_string(decodedHeight));
+   if(decoded.size() != 3*width*height)
+      return;
+
+   size_t rowBytes = 3*width;
+   for(size_t y = 0; y < height; ++y)
+   {
+      bool same = y < numRows ? memcmp(&decoded[y*rowBytes], &rgb[y*rowBytes], rowBytes) == 0 :
+                                std::all_of(&decoded[y*rowBytes], &decoded[(y+1)*rowBytes], [](unsigned char c){return c == 0;});
+      if(!same)
+      {
+         check(false, test, "row " + std::to_string(y) + (y < numRows ? " differs" : " isn't black"));
+         return;
+      }
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   std::string path = (fs::temp_directory_path() / ("pngEncoderTest_" + std::to_string(getpid()) + ".png")).string();
+   WorkerPool noThreads(0);
+   WorkerPool threads(3);
+
+   // Sizes: a single pixel, a width that isn't a multiple of anything, a single strip, many strips
+   // (strips are about 1 MB) and rows that are each a strip of their own.
+   struct tSize{size_t width; size_t height;};
+   const tSize sizes[] = {{1, 1}, {7, 5}, {300, 20}, {1000, 1200}, {400000, 3}};
+   for(const tSize& size : sizes)
+   {
+      std::vector<uint8_t> rgb = makeImage(size.width, size.height, unsigned(size.width + size.height));
+      for(bool fastEncode : {true, false})
+      {
+         std::string name = std::to_string(size.width) + "x" + std::to_string(size.height) + (fastEncode ? " fast" : " slow");
+
+         // The whole image at once, with and without worker threads.
+         check(savePngParallel(path, rgb.data(), size.width, size.height, noThreads, fastEncode), name, "save");
+         checkDecode(name, path, rgb, size.width, size.height, size.height);
+         check(savePngParallel(path, rgb.data(), size.width, size.height, threads, fastEncode), name + " threads", "save");
+         checkDecode(name + " threads", path, rgb, size.width, size.height, size.height);
+
+         // Streamed a few rows at a time.
+         {
+            PngStreamWriter png(path, size.width, size.height, fastEncode);
+            for(size_t row = 0, numRows = 1; row < size.height; row += numRows, numRows = numRows*2 + 1)
+               png.writeRows(&rgb[3*size.width*row], std::min(numRows, size.height - row), &threads);
+            check(png.finish(), name + " streamed", "finish");
+         }
+         checkDecode(name + " streamed", path, rgb, size.width, size.height, size.height);
+
+         // Not all the rows written, finish() fills the rest with black.
+         {
+            size_t numRows = size.height / 2;
+            PngStreamWriter png(path, size.width, size.height, fastEncode);
+            png.writeRows(rgb.data(), numRows, &threads);
+            check(png.finish(), name + " padded", "finish");
+            checkDecode(name + " padded", path, rgb, size.width, size.height, numRows);
+         }
+      }
+   }
+
+   fs::remove(path);
+   if(g_numFailures > 0)
+   {
+      fprintf(stderr, "%d failures\n", g_numFailures);
+      return 1;
+   }
+   printf("All tests passed\n");
+   return 0;
+}